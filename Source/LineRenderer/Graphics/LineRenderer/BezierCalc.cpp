@@ -1,417 +1,1260 @@
-// Copyright Hollywood Camera Work
-
-#include "BezierCalc.h"
-
-void FBezierCalc::Calculate()
-{
-    // Calculate Tangents
-    
-    if (HardCorners) {
-        // These are straight line segments. Copy them directly in.
-        Tessellated.SetNum(Points.Num());
-        SegmentTessIndexes.SetNumZeroed(Points.Num());
-        SegmentLengths.SetNumZeroed(Points.Num());
-
-        for (int i = 0; i < Points.Num(); ++i) {
-            Tessellated[i] = Points[i];
-            SegmentTessIndexes[i] = i;
-
-            if (i < Points.Num() - 1) {
-                SegmentLengths[i] = (Points[i + 1] - Points[i]).Size();
-            } else {
-                SegmentLengths[i] = 0; // Last point is not a segment.
-            }
-        }
-    } else {
-        // Soft line. Calculate auto tangents.
-        CalculateTangents();
-        CalculateBezier();
-    }
-}
-
-void FBezierCalc::CalculateTangents()
-{
-    // Ensure the tangents arrays are empty and then set to the correct size
-    OutTangents.Empty(Points.Num());
-    OutTangents.AddZeroed(Points.Num());
-    InTangents.Empty(Points.Num());
-    InTangents.AddZeroed(Points.Num());
-
-    // Calculate for the middle points' incoming and outgoing tangents
-    for (int32 i = 1; i < Points.Num() - 1; ++i) {
-        FVector PrevPoint = Points[i - 1];
-        FVector CurrPoint = Points[i];
-        FVector NextPoint = Points[i + 1];
-
-        // Calculate normalized direction vectors for segments
-        FVector DirToPrev = (CurrPoint - PrevPoint).GetSafeNormal();
-        FVector DirToNext = (NextPoint - CurrPoint).GetSafeNormal();
-
-        // The tangent direction is the normalized average of the vectors to the previous and next points
-        FVector TangentDir = (DirToPrev + DirToNext).GetSafeNormal();
-
-        // Calculate the distances from the current point to the previous and next points
-        float DistToPrev = (CurrPoint - PrevPoint).Size();
-        float DistToNext = (NextPoint - CurrPoint).Size();
-
-        // The outgoing tangent has the same direction as the average direction
-        OutTangents[i] = TangentDir * TangentStrength * DistToNext;
-
-        // The incoming tangent has the inverted direction
-        InTangents[i] = TangentDir * TangentStrength * DistToPrev;
-    }
-
-    if (Points.Num() > 1) {
-        FVector SecondPoint = Points[1];
-        FVector FirstPoint = Points[0];
-        // Calculate the target point for the outgoing tangent of the first point
-        // It's the second point's position minus its incoming tangent (which points towards the first point)
-        FVector TargetPointForTangent = SecondPoint - InTangents[1];
-        FVector DirToNextIncomingTangent = (TargetPointForTangent - FirstPoint).GetSafeNormal();
-        float DistToNext = (SecondPoint - FirstPoint).Size();
-        OutTangents[0] = DirToNextIncomingTangent * TangentStrength * DistToNext;
-    }
-
-    // Calculate for the last point's incoming tangent, which should now point towards the outgoing tangent of the second-to-last point
-    if (Points.Num() > 2) {
-        FVector SecondToLastPoint = Points[Points.Num() - 2];
-        FVector LastPoint = Points.Last();
-        // The direction should be from the last point towards the position that is the second-to-last point plus its outgoing tangent
-        FVector TargetPointForTangent = SecondToLastPoint + OutTangents[Points.Num() - 2]; // This gives us the target point in world space
-        FVector DirFromSecondToLastOutgoingTangent = (TargetPointForTangent - LastPoint).GetSafeNormal();
-        float DistToLast = (LastPoint - SecondToLastPoint).Size();
-        InTangents.Last() = -DirFromSecondToLastOutgoingTangent * TangentStrength * DistToLast;
-    }
-}
-
-void FBezierCalc::CalculateBezier()
-{
-    Tessellated.Empty();
-    SegmentTessIndexes.SetNumZeroed(Points.Num());
-    SegmentLengths.SetNumZeroed(Points.Num());
-    SegmentStartLengths.SetNumZeroed(Points.Num());
-    
-    if (Points.Num() < 2) {
-        return;
-    }
-
-    TotalLength = 0;
-    
-    for (int32 i = 0; i < Points.Num(); ++i) {
-        SegmentTessIndexes[i] = Tessellated.Num();
-        float SegmentLength = 0;
-
-        if (i < Points.Num() - 1) {
-            FVector P0 = Points[i];
-            FVector P1 = Points[i + 1];
-
-            TessellateSegment(i, 0, P0, 1, P1, Tessellated); // Recursive
-
-            // Add distance to next point to complete the segment.
-            // SegmentLength += FVector::Dist(Tessellated.Last(), P1);
-
-            SegmentLength = 0;
-            for (int32 j = SegmentTessIndexes[i]; j < Tessellated.Num() - 1; ++j) {
-                SegmentLength += FVector::Dist(Tessellated[j], Tessellated[j + 1]);
-            }
-            SegmentLength += FVector::Dist(Tessellated.Last(), P1);
-        } else {
-            Tessellated.Add(Points[i]); // Last point is not a full segment
-        }
-        
-        SegmentLengths[i] = SegmentLength;
-        SegmentStartLengths[i] = TotalLength;
-        TotalLength += SegmentLength;
-    }
-    
-    // UE_LOG(LogTemp, Log, TEXT("Total length after calculate bezier: %f"), TotalLength);
-    // for (int32 i = 0; i < Points.Num(); ++i) {
-    //     UE_LOG(LogTemp, Log, TEXT("Segment %d tess index: %d"), i, SegmentTessIndexes[i]);
-    // }
-    // for (int32 i = 0; i < Points.Num(); ++i) {
-    //     UE_LOG(LogTemp, Log, TEXT("Segment %d length: %f"), i, SegmentLengths[i]);
-    // }
-}
-
-void FBezierCalc::TessellateSegment(const int32 SegmentIndex, const float T0, const FVector& P0, const float T1, const FVector& P1, TArray<FVector>& TesPoints)
-{
-    constexpr float NearPoint = 0.2f;
-    constexpr float FarPoint = 0.8f;
-    const FVector CurvedMidPoint = CalculateBezierPoint(SegmentIndex, FMath::Lerp(T0, T1, 0.5f));
-    const float EffectiveQuality = FMath::Lerp(50.0, 0.01, (TessellationQuality));
-
-    // Compare the curved samples against linear samples to see if the deviation is too great and we
-    // need to tessellate this segment. This is crammed into a convoluted if statement to benefit
-    // from short-circuiting. The decision can almost always be made just with the center point, but
-    // there are some cases where the center point is exactly equal to the middle of a very curved
-    // line, so we have to sample also the near and far points.
-    
-    if (
-        (CurvedMidPoint - FMath::Lerp(P0, P1, 0.5f)).Size() > EffectiveQuality ||
-        (CalculateBezierPoint(SegmentIndex, FMath::Lerp(T0, T1, NearPoint)) - FMath::Lerp(P0, P1, NearPoint)).Size() > EffectiveQuality ||
-        (CalculateBezierPoint(SegmentIndex, FMath::Lerp(T0, T1, FarPoint)) - FMath::Lerp(P0, P1, FarPoint)).Size() > EffectiveQuality
-    ) {
-        TessellateSegment(SegmentIndex, T0, P0, (T0 + T1) * 0.5f, CurvedMidPoint, TesPoints);
-        TessellateSegment(SegmentIndex, (T0 + T1) * 0.5f, CurvedMidPoint, T1, P1, TesPoints);
-    } else {
-        // Doesn't need any more tessellation.
-        // auto AddPoint = [&TesPoints](const FVector& CurPoint) ->void {
-        //     if (TesPoints.Num() != 0) {
-        //         const FVector& PrevPoint = TesPoints.Last();
-        //     }
-        //     TesPoints.Add(CurPoint);
-        // };
-
-        TesPoints.Add(P0);
-        TesPoints.Add(CurvedMidPoint);
-
-        // AddPoint(P0);
-        // AddPoint(CurvedMidPoint);
-    }
-}
-
-FVector FBezierCalc::CalculateBezierPoint(float FloatProgress)
-{
-    // UE_LOG(LogTemp, Log, TEXT("CalculateBezierPoint"));
-
-    if (FloatProgress >= Points.Num() - 1) {
-        return Points.Last();
-    }
-    
-    FloatProgress = FMath::Clamp(FloatProgress, 0, Points.Num());
-    int32 Segment = 0;
-    float Progress = 0;
-    DecomposeFloatProgress(FloatProgress, Segment, Progress);
-
-    // Ensure the segment index is within the bounds of the Points array
-    if (Segment < 0 || Segment >= Points.Num() - 1) {
-        UE_LOG(LogTemp, Warning, TEXT("Segment index out of bounds"));
-        return FVector::ZeroVector; // Return a default value to avoid crashing
-    }
-
-    // Get the control points for this segment
-    const FVector P0 = Points[Segment];
-    const FVector P1 = P0 + OutTangents[Segment];
-    const FVector P2 = Points[Segment + 1] - InTangents[Segment + 1];
-    const FVector P3 = Points[Segment + 1];
-
-    // Calculate the cubic Bezier point at SegmentProgress
-    const float T = Progress;
-    const float OneMinusT = 1.0f - T;
-    const FVector Point = OneMinusT * OneMinusT * OneMinusT * P0 + 
-                    3.0f * OneMinusT * OneMinusT * T * P1 + 
-                    3.0f * OneMinusT * T * T * P2 + 
-                    T * T * T * P3;
-
-    return Point;
-}
-
-FVector FBezierCalc::CalculateBezierPoint(const int32 Segment, const float Progress)
-{
-    const float FloatProgress = FMath::Clamp(Segment, 0, Points.Num()) + FMath::Clamp(Progress, 0, 1);
-    return CalculateBezierPoint(FloatProgress);
-}
-
-void FBezierCalc::DecomposeFloatProgress(float FloatProgress, int32& Segment, float& Progress) const
-{
-    // Splits a float progress like 1.7 into Segment = (int) 1, Progress = (float) 0.7
-    FloatProgress = FMath::Clamp(FloatProgress, 0, Points.Num());
-    float SegmentFloat = 0;
-    Progress = FMath::Modf(FloatProgress, &SegmentFloat);
-    Segment = static_cast<int32>(SegmentFloat);
-}
-
-FVector FBezierCalc::SlopeAtPoint(float FloatProgress)
-{
-    // UE_LOG(LogTemp, Log, TEXT("SlopeAtPoint"));
-
-    const float FloatMax = Points.Num();
-    FloatProgress = FMath::Clamp(FloatProgress, 0, FloatMax);
-    constexpr float Margin = 0.01;
-    
-    // Get a left and a right that are plus/minus 0.01. Clamp that to the allowed range from 0 to
-    // Segment+1. Then ensure that there's still a gap of Margin*2 between them.
-
-    const float Left = FMath::Clamp(FMath::Clamp(FloatProgress - Margin, 0, FloatMax), 0, FloatMax - 2 * Margin);
-    const float Right = FMath::Clamp(FMath::Clamp(FloatProgress + Margin, 0, FloatMax), 2 * Margin, FloatMax);
-    
-    const FVector P0 = CalculateBezierPoint(Left);
-    const FVector P1 = CalculateBezierPoint(Right);
-    const FVector Slope = (P1 - P0).GetSafeNormal();
-    return Slope;
-}
-
-FVector FBezierCalc::PerpendicularAtPoint(float FloatProgress, const FVector& UpVector)
-{
-    // UE_LOG(LogTemp, Log, TEXT("PerpendicularAtPoint"));
-    
-    FloatProgress = FMath::Clamp(FloatProgress, 0, Points.Num() - 1);
-    const FVector Slope = SlopeAtPoint(FloatProgress);
-    const FVector Perpendicular = FVector::CrossProduct(Slope, UpVector).GetSafeNormal();
-    return Perpendicular;
-}
-
-FVector FBezierCalc::CalculateLinearPoint(const float Progress)
-{
-    // Only works when bezier is calculated. First early exits.
-
-    if (Points.Num() == 0) {
-        return FVector::ZeroVector;
-    } else if (Points.Num() == 1) {
-        return Points[0];
-    }
-
-    if (Progress <= 0) {
-        return Points[0];
-    } else if (Progress >= 1) {
-        return Points[Points.Num() - 1];
-    }
-
-    const float PathLength = FMath::Lerp(0, TotalLength, Progress);
-
-    for (int32 Segment = 0; Segment < Points.Num() - 1; ++Segment) {
-        // Get left and right length bounds for this segment.
-        const float LeftLength = SegmentStartLengths[Segment];
-        const float RightLength = SegmentStartLengths[Segment + 1];
-
-        // If we're within this segment, find our progress within it.
-        if (LeftLength <= PathLength && PathLength < RightLength) {
-            if (LeftLength != RightLength) {
-                return CalculateBezierPoint(Segment, (PathLength - LeftLength) / (RightLength - LeftLength));
-            }
-
-            // We shouldn't ever be here, because if the segment has no length, we wouldn't be in
-            // the outer if in the first place.
-            UE_LOG(LogTemp, Warning, TEXT("Cannot calculate linear position for zero-length segment. Should be impossible."));
-            return CalculateBezierPoint(Segment, 0);
-        }
-    }
-
-    // If nothing found, there's an error in the underlying data. Log an error and return first
-    // point.
-
-    UE_LOG(LogTemp, Warning, TEXT("Cannot calculate linear position for zero-length segment. Should be impossible."));
-    return CalculateBezierPoint(0, 0);
-}
-
-//
-// HIT DETECTION
-//
-
-FHitDetectionResult FBezierCalc::HitDetectPoints(const APlayerController* Player, const FVector2D& HitPos)
-{
-    FVector2D Projected(0, 0);
-    FHitDetectionResult Result;
-    
-    for (int32 i = 0; i < Points.Num(); ++i) {
-        const FVector& Point = Points[i];
-        
-        const bool IsOnScreen = Player->ProjectWorldLocationToScreen(Point, Projected, false);
-        const float Distance = FVector2D::Distance(HitPos, Projected);
-        
-        if (IsOnScreen && Distance < Result.Distance) {
-            // Result.IsOnScreen = true;
-            Result.Segment = i;
-            Result.Distance = Distance;
-            Result.Valid = true;
-        }
-    }
-
-    return MoveTemp(Result);
-}
-
-FHitDetectionResult FBezierCalc::HitDetectSpline(const APlayerController* Player, const FVector2D& HitPos)
-{
-    TArray<FVector2D> ScreenLinePoints;
-
-    // Convert line to screen coordinates
-    
-    for (const FVector& TessPoint : Tessellated) {
-        FVector2D Projected;
-        Player->ProjectWorldLocationToScreen(TessPoint, Projected, false);
-        ScreenLinePoints.Add(Projected);
-    }
-
-    // Find line fragment with closest match
-    
-    FHitDetectionResult Result;
-    int32 Segment = 0;
-    float ProgressLength = 0;
-    
-    for (int32 i = 0; i < Tessellated.Num() - 1; ++i) {
-        while (i >= SegmentTessIndexes[Segment + 1]) {
-            ++Segment;
-            ProgressLength = 0;
-        }
-        
-        // Prepare 2D values
-        const FVector2D& FromScreenPoint = ScreenLinePoints[i];
-        const FVector2D& ToScreenPoint = ScreenLinePoints[i + 1];
-        const FVector2D ScreenLineVector = ToScreenPoint - FromScreenPoint;
-        const FVector2D HitPointVector = HitPos - FromScreenPoint;
-
-        // Prepare 3D values
-        const FVector& FromTessPoint = Tessellated[i];
-        const FVector& ToTessPoint = Tessellated[i + 1];
-        const float FragmentLength = (ToTessPoint - FromTessPoint).Size();
-        // UE_LOG(LogTemp, Log, TEXT("Fragment %d length %f"), i, FragmentLength);
-        
-        // Project PointVector onto LineVector
-        const float LineLengthSquared = ScreenLineVector.SizeSquared();
-        const float Projection = FVector2D::DotProduct(HitPointVector, ScreenLineVector) / LineLengthSquared;
-
-        // Clamp the projection value to the range [0, 1] to stay on the line segment
-        const float FragmentProgress = FMath::Clamp(Projection, 0.0f, 1.0f);
-
-        // Find the closest point on the line
-        const FVector2D ClosestPoint = FromScreenPoint + ScreenLineVector * FragmentProgress;
-
-        // Calculate distance and position on line
-        const float DistanceToPoint = (HitPos - ClosestPoint).Size();
-
-        if (DistanceToPoint < Result.Distance) {
-            const float LengthAlongLine = ProgressLength + FragmentProgress * FragmentLength;
-            Result.Progress = LengthAlongLine / SegmentLengths[Segment];
-            Result.Distance = DistanceToPoint;
-            Result.Segment = Segment;
-            Result.Valid = true;
-
-            if (Result.Progress >= 1) {
-                Result.Progress -= 1;
-                Result.Segment += 1;
-            }
-        }
-
-        ProgressLength += FragmentLength;
-        // UE_LOG(LogTemp, Log, TEXT("Segment: %d, ProgressLength: %f, SegmentLength: %f"), Segment, ProgressLength, SegmentLengths[Segment]);
-    }
-    
-    return MoveTemp(Result);
-}
-
-//
-// UTILITY
-//
-
-void FBezierCalc::DumpTessellated() const
-{
-    UE_LOG(LogTemp, Log, TEXT("*************** DUMP TESSELLATED ***************"));
-
-    if (Tessellated.Num() == 0)
-        return;
-
-    FVector PreviousPoint = FVector::ZeroVector;
-    float TotalDist = 0;
-    
-    for (int i = 0; i < Tessellated.Num(); ++i) {
-        const FVector& CurrentPoint = Tessellated[i];
-        const float Distance = (i == 0) ? 0 : FVector::Dist(PreviousPoint, CurrentPoint);
-        TotalDist += Distance;
-
-        UE_LOG(LogTemp, Log, TEXT("Point %d: (%s), Distance from Previous: %f"), i, *CurrentPoint.ToString(), Distance);
-
-        PreviousPoint = CurrentPoint;
-    }
-
-    UE_LOG(LogTemp, Log, TEXT("Total length: %f, Total tess points: %d"), TotalDist, Tessellated.Num());
-}
+// Copyright Hollywood Camera Work
+
+#include "BezierCalc.h"
+
+#include "Algo/BinarySearch.h"
+#include "LineHitQueryContext.h"
+
+void FBezierCalc::Calculate()
+{
+    TessIndexBase = 0;
+    
+    // Calculate Tangents
+    
+    if (HardCorners) {
+        // These are straight line segments. Copy them directly in.
+        FLineScratchStats::Reserve(Tessellated, Points.Num());
+        FLineScratchStats::Reserve(TessProgress, Points.Num());
+        FLineScratchStats::Reserve(SegmentTessIndexes, Points.Num());
+        Tessellated.SetNum(Points.Num(), false);
+        TessProgress.SetNumZeroed(Points.Num(), false);
+        SegmentTessIndexes.SetNumZeroed(Points.Num(), false);
+
+        for (int i = 0; i < Points.Num(); ++i) {
+            Tessellated[i] = Points[i];
+            TessProgress[i] = 0;
+            SegmentTessIndexes[i] = i;
+        }
+    } else {
+        // Soft line. Calculate auto tangents.
+        CalculateTangents();
+    }
+
+    CalculateCoefficients(0, Points.Num() - 2);
+
+    if (!HardCorners) {
+        CalculateBezier();
+    }
+
+    CalculateLengths();
+
+    PointBvh.Invalidate();
+    SplineBvh.Invalidate();
+}
+
+bool FBezierCalc::CalculateRange(const int32 FirstPoint, const int32 LastPoint, FTessellationSplice& OutSplice)
+{
+    // Partial version of Calculate() for when the points from FirstPoint to LastPoint have moved.
+    // Points must already hold the new positions, and the previous calculation must have been done
+    // with the same number of points and the same settings. Only the tangents, coefficients and
+    // tessellation depending on the moved points are recalculated, and the new tessellated points
+    // are spliced into place. Returns false without changing anything if the previous calculation
+    // doesn't match.
+
+    const int32 NumPoints = Points.Num();
+    if (FirstPoint < 0 || LastPoint >= NumPoints || FirstPoint > LastPoint || !MatchesCalculation(NumPoints)) {
+        return false;
+    }
+
+    SpliceRange(FirstPoint, LastPoint, OutSplice);
+    return true;
+}
+
+bool FBezierCalc::AppendRange(const int32 NumAppended, FTessellationSplice& OutSplice)
+{
+    // Partial version of Calculate() for when points were added to the end of the line. Points
+    // must already hold the new points, and the previous calculation must have been done with the
+    // points before them and the same settings. Only the last segment before the new points (whose
+    // end tangent changes) and the new segments are tessellated. Returns false without changing
+    // anything if the previous calculation doesn't match.
+
+    const int32 NumPoints = Points.Num();
+    if (NumAppended <= 0 || !MatchesCalculation(NumPoints - NumAppended)) {
+        return false;
+    }
+
+    if (!HardCorners) {
+        InTangents.SetNumZeroed(NumPoints, false);
+        OutTangents.SetNumZeroed(NumPoints, false);
+    }
+    SegmentTessIndexes.SetNumZeroed(NumPoints, false);
+
+    SpliceRange(NumPoints - NumAppended, NumPoints - 1, OutSplice);
+    return true;
+}
+
+bool FBezierCalc::TrimFront(const int32 NumTrimmed, FTessellationSplice& OutSplice)
+{
+    // Partial version of Calculate() for when points were removed from the start of the line.
+    // Points must already have them removed, and the previous calculation must have been done with
+    // them and the same settings. The removed segments are dropped off the front of the arrays
+    // without moving the rest, and the rest keeps its tessellation and lengths. The new first point
+    // is an end of the line now, so its tangent and the first segment are calculated again, the
+    // same as a full calculation would.
+    //
+    // Returns false without changing anything if the previous calculation doesn't match, or if
+    // fewer than three points are left, since the tangents at both ends then depend on each other.
+    // Also returns false once more length has been trimmed than is left, so that a full calculation
+    // starts the lengths from 0 again before they lose precision.
+
+    const int32 NumPoints = Points.Num();
+    if (NumTrimmed <= 0 || NumPoints < 3 || !MatchesCalculation(NumPoints + NumTrimmed)) {
+        return false;
+    }
+
+    const int32 TessTrimmed = SegmentTessIndex(NumTrimmed);
+    if (TessLengths[TessTrimmed] > TessLengths.Last() - TessLengths[TessTrimmed]) {
+        return false;
+    }
+
+    Tessellated.TrimFront(TessTrimmed);
+    TessProgress.TrimFront(TessTrimmed);
+    TessLengths.TrimFront(TessTrimmed);
+    TessIndexBase += TessTrimmed;
+
+    SegmentTessIndexes.TrimFront(NumTrimmed);
+    SegmentLengths.TrimFront(NumTrimmed);
+    SegmentStartLengths.TrimFront(NumTrimmed);
+    Coefficients.TrimFront(NumTrimmed);
+    SegmentBounds.TrimFront(NumTrimmed);
+
+    OutSplice = FTessellationSplice();
+    OutSplice.Trimmed = TessTrimmed;
+
+    if (!HardCorners) {
+        InTangents.TrimFront(NumTrimmed);
+        OutTangents.TrimFront(NumTrimmed);
+
+        // A full calculation leaves the first point without an incoming tangent, and aims its
+        // outgoing tangent at the incoming tangent of the second point.
+        InTangents[0] = FVector::ZeroVector;
+        CalculateTangentRange(0, 0);
+        CalculateCoefficients(0, 0);
+
+        SpliceTessellated.Reset();
+        SpliceProgress.Reset();
+        TessellateSegment(0, SpliceTessellated, SpliceProgress);
+
+        const int32 OldEnd = SegmentTessIndex(1);
+        const int32 NewEnd = SpliceTessellated.Num();
+        const int32 Delta = NewEnd - OldEnd;
+
+        if (Delta > 0) {
+            Tessellated.InsertUninitialized(0, Delta);
+            TessProgress.InsertUninitialized(0, Delta);
+            TessLengths.InsertUninitialized(0, Delta);
+        } else if (Delta < 0) {
+            Tessellated.TrimFront(-Delta);
+            TessProgress.TrimFront(-Delta);
+            TessLengths.TrimFront(-Delta);
+        }
+        TessIndexBase -= Delta;
+        SegmentTessIndexes[0] = TessIndexBase;
+
+        FMemory::Memcpy(Tessellated.GetData(), SpliceTessellated.GetData(), NewEnd * sizeof(FVector));
+        FMemory::Memcpy(TessProgress.GetData(), SpliceProgress.GetData(), NewEnd * sizeof(float));
+
+        // The lengths from the second point on stay as they were, so the first segment's are
+        // counted back from there.
+        for (int32 i = NewEnd - 1; i >= 0; --i) {
+            TessLengths[i] = TessLengths[i + 1] - FVector::Dist(Tessellated[i], Tessellated[i + 1]);
+        }
+        SegmentStartLengths[0] = TessLengths[0];
+        SegmentLengths[0] = SegmentStartLengths[1] - SegmentStartLengths[0];
+
+        OutSplice.TrimOldEnd = OldEnd;
+        OutSplice.TrimNewEnd = NewEnd;
+    }
+
+    TotalLength = TessLengths.Last() - TessLengths[0];
+
+    PointBvh.Invalidate();
+    SplineBvh.Invalidate();
+    return true;
+}
+
+bool FBezierCalc::MatchesCalculation(const int32 NumPoints) const
+{
+    // Whether the derived data is from a full calculation with NumPoints points, which the partial
+    // calculations build on.
+    
+    return NumPoints >= 2 &&
+        Coefficients.Num() == NumPoints - 1 &&
+        SegmentTessIndexes.Num() == NumPoints &&
+        Tessellated.Num() == SegmentTessIndex(NumPoints - 1) + 1 &&
+        (HardCorners || InTangents.Num() == NumPoints);
+}
+
+void FBezierCalc::SpliceRange(const int32 FirstPoint, const int32 LastPoint, FTessellationSplice& OutSplice)
+{
+    // Recalculates everything depending on the points from FirstPoint to LastPoint, and splices
+    // the new tessellated points into place. Only the trim is kept from the incoming splice.
+    
+    const int32 NumPoints = Points.Num();
+
+    // A point's tangents depend on its neighbours, and the tangents at the ends of the line also
+    // depend on the tangents next to them. A segment depends on the tangents at both its ends.
+    // Hard-cornered segments only depend on their own points.
+    
+    int32 SegmentFirst = FMath::Max(FirstPoint - 1, 0);
+    int32 SegmentLast = FMath::Min(LastPoint, NumPoints - 2);
+
+    if (!HardCorners) {
+        int32 TangentFirst = FMath::Max(FirstPoint - 1, 0);
+        int32 TangentLast = FMath::Min(LastPoint + 1, NumPoints - 1);
+        if (TangentFirst <= 1) {
+            TangentFirst = 0;
+        }
+        if (TangentLast >= NumPoints - 2) {
+            TangentLast = NumPoints - 1;
+        }
+        CalculateTangentRange(TangentFirst, TangentLast);
+        
+        SegmentFirst = FMath::Max(TangentFirst - 1, 0);
+        SegmentLast = FMath::Min(TangentLast, NumPoints - 2);
+    }
+
+    CalculateCoefficients(SegmentFirst, SegmentLast);
+
+    // Tessellate the affected segments into the scratch buffers. The last point of the line is
+    // stored after the last segment, so it's included when the last segment is.
+    
+    const bool IncludesLastPoint = (SegmentLast == NumPoints - 2);
+    const int32 First = SegmentTessIndex(SegmentFirst);
+    const int32 OldEnd = IncludesLastPoint ? Tessellated.Num() : SegmentTessIndex(SegmentLast + 1);
+
+    SpliceTessellated.Reset();
+    SpliceProgress.Reset();
+
+    for (int32 i = SegmentFirst; i <= SegmentLast; ++i) {
+        SegmentTessIndexes[i] = TessIndexBase + First + SpliceTessellated.Num();
+        
+        if (HardCorners) {
+            SpliceTessellated.Add(Points[i]);
+            SpliceProgress.Add(0);
+        } else {
+            TessellateSegment(i, SpliceTessellated, SpliceProgress);
+        }
+    }
+
+    if (IncludesLastPoint) {
+        SegmentTessIndexes.Last() = TessIndexBase + First + SpliceTessellated.Num();
+        SpliceTessellated.Add(Points.Last());
+        SpliceProgress.Add(0);
+    }
+
+    // Make room for the new points (or close the gap), shifting the rest of the line along.
+    
+    const int32 NewEnd = First + SpliceTessellated.Num();
+    const int32 Delta = NewEnd - OldEnd;
+    const float OldLengthAtEnd = (OldEnd < Tessellated.Num()) ? TessLengths[OldEnd] : 0;
+
+    if (Delta > 0) {
+        Tessellated.InsertUninitialized(OldEnd, Delta);
+        TessProgress.InsertUninitialized(OldEnd, Delta);
+        TessLengths.InsertUninitialized(OldEnd, Delta);
+    } else if (Delta < 0) {
+        Tessellated.RemoveAt(NewEnd, -Delta, false);
+        TessProgress.RemoveAt(NewEnd, -Delta, false);
+        TessLengths.RemoveAt(NewEnd, -Delta, false);
+    }
+
+    FMemory::Memcpy(&Tessellated[First], SpliceTessellated.GetData(), SpliceTessellated.Num() * sizeof(FVector));
+    FMemory::Memcpy(&TessProgress[First], SpliceProgress.GetData(), SpliceProgress.Num() * sizeof(float));
+
+    if (!IncludesLastPoint) {
+        for (int32 i = SegmentLast + 1; i < NumPoints; ++i) {
+            SegmentTessIndexes[i] += Delta;
+        }
+    }
+
+    // Recalculate lengths for the new points, and the point following them. The rest of the line
+    // only shifts by the change in length. The first length stays where it is.
+    
+    const int32 LengthEnd = FMath::Min(NewEnd, Tessellated.Num() - 1);
+    for (int32 i = FMath::Max(First, 1); i <= LengthEnd; ++i) {
+        TessLengths[i] = TessLengths[i - 1] + FVector::Dist(Tessellated[i - 1], Tessellated[i]);
+    }
+
+    if (NewEnd < Tessellated.Num()) {
+        const float LengthDelta = TessLengths[NewEnd] - OldLengthAtEnd;
+        for (int32 i = NewEnd + 1; i < Tessellated.Num(); ++i) {
+            TessLengths[i] += LengthDelta;
+        }
+    }
+
+    CalculateSegmentLengths(SegmentFirst);
+
+    OutSplice.First = First;
+    OutSplice.OldEnd = OldEnd;
+    OutSplice.NewEnd = NewEnd;
+
+    PointBvh.Invalidate();
+    SplineBvh.Invalidate();
+}
+
+void FBezierCalc::CalculateTangents()
+{
+    // Ensure the tangents arrays are empty and then set to the correct size
+    FLineScratchStats::Reserve(OutTangents, Points.Num());
+    FLineScratchStats::Reserve(InTangents, Points.Num());
+    OutTangents.Reset();
+    OutTangents.AddZeroed(Points.Num());
+    InTangents.Reset();
+    InTangents.AddZeroed(Points.Num());
+
+    CalculateTangentRange(0, Points.Num() - 1);
+}
+
+void FBezierCalc::CalculateTangentRange(const int32 First, const int32 Last)
+{
+    // Calculates the tangents of the points from First to Last. The end tangents depend on the
+    // tangents next to them, so those are calculated last.
+    
+    // Calculate for the middle points' incoming and outgoing tangents
+    for (int32 i = FMath::Max(First, 1); i <= Last && i < Points.Num() - 1; ++i) {
+        FVector PrevPoint = Points[i - 1];
+        FVector CurrPoint = Points[i];
+        FVector NextPoint = Points[i + 1];
+
+        // Calculate normalized direction vectors for segments
+        FVector DirToPrev = (CurrPoint - PrevPoint).GetSafeNormal();
+        FVector DirToNext = (NextPoint - CurrPoint).GetSafeNormal();
+
+        // The tangent direction is the normalized average of the vectors to the previous and next points
+        FVector TangentDir = (DirToPrev + DirToNext).GetSafeNormal();
+
+        // Calculate the distances from the current point to the previous and next points
+        float DistToPrev = (CurrPoint - PrevPoint).Size();
+        float DistToNext = (NextPoint - CurrPoint).Size();
+
+        // The outgoing tangent has the same direction as the average direction
+        OutTangents[i] = TangentDir * TangentStrength * DistToNext;
+
+        // The incoming tangent has the inverted direction
+        InTangents[i] = TangentDir * TangentStrength * DistToPrev;
+    }
+
+    if (Points.Num() > 1 && First <= 0) {
+        FVector SecondPoint = Points[1];
+        FVector FirstPoint = Points[0];
+        // Calculate the target point for the outgoing tangent of the first point
+        // It's the second point's position minus its incoming tangent (which points towards the first point)
+        FVector TargetPointForTangent = SecondPoint - InTangents[1];
+        FVector DirToNextIncomingTangent = (TargetPointForTangent - FirstPoint).GetSafeNormal();
+        float DistToNext = (SecondPoint - FirstPoint).Size();
+        OutTangents[0] = DirToNextIncomingTangent * TangentStrength * DistToNext;
+    }
+
+    // Calculate for the last point's incoming tangent, which should now point towards the outgoing tangent of the second-to-last point
+    if (Points.Num() > 2 && Last >= Points.Num() - 1) {
+        FVector SecondToLastPoint = Points[Points.Num() - 2];
+        FVector LastPoint = Points.Last();
+        // The direction should be from the last point towards the position that is the second-to-last point plus its outgoing tangent
+        FVector TargetPointForTangent = SecondToLastPoint + OutTangents[Points.Num() - 2]; // This gives us the target point in world space
+        FVector DirFromSecondToLastOutgoingTangent = (TargetPointForTangent - LastPoint).GetSafeNormal();
+        float DistToLast = (LastPoint - SecondToLastPoint).Size();
+        InTangents.Last() = -DirFromSecondToLastOutgoingTangent * TangentStrength * DistToLast;
+    }
+}
+
+void FBezierCalc::CalculateCoefficients(const int32 First, const int32 Last)
+{
+    // Convert each segment from bezier control points to power-basis coefficients, so that
+    // evaluation is a single Horner step. Hard-cornered segments are straight lines with linear
+    // progress.
+    
+    const int32 NumSegments = FMath::Max(Points.Num() - 1, 0);
+    FLineScratchStats::Reserve(Coefficients, NumSegments);
+    FLineScratchStats::Reserve(SegmentBounds, NumSegments);
+    Coefficients.SetNumUninitialized(NumSegments, false);
+    SegmentBounds.SetNumUninitialized(NumSegments, false);
+
+    for (int32 i = FMath::Max(First, 0); i <= Last && i < NumSegments; ++i) {
+        FBezierCoefficients& Coeffs = Coefficients[i];
+        FBox& Bounds = SegmentBounds[i];
+        const FVector& P0 = Points[i];
+        const FVector& P3 = Points[i + 1];
+
+        if (HardCorners) {
+            Coeffs.A = FVector::ZeroVector;
+            Coeffs.B = FVector::ZeroVector;
+            Coeffs.C = P3 - P0;
+            Coeffs.D = P0;
+            Bounds = FBox(ForceInit) + P0 + P3;
+        } else {
+            const FVector P1 = P0 + OutTangents[i];
+            const FVector P2 = P3 - InTangents[i + 1];
+            Coeffs.A = (P1 - P2) * 3.0f + P3 - P0;
+            Coeffs.B = (P0 - P1 * 2.0f + P2) * 3.0f;
+            Coeffs.C = (P1 - P0) * 3.0f;
+            Coeffs.D = P0;
+            // The curve stays within the hull of its control points.
+            Bounds = FBox(ForceInit) + P0 + P1 + P2 + P3;
+        }
+    }
+}
+
+void FBezierCalc::CalculateBezier()
+{
+    // The arrays keep their allocations from the previous calculation.
+    Tessellated.Reset();
+    TessProgress.Reset();
+    FLineScratchStats::Reserve(SegmentTessIndexes, Points.Num());
+    SegmentTessIndexes.SetNumZeroed(Points.Num(), false);
+    
+    if (Points.Num() < 2) {
+        return;
+    }
+
+    // Reserve up front, so that appending tessellated points doesn't reallocate.
+    
+    int32 Estimate = 1;
+    for (int32 i = 0; i < Points.Num() - 1; ++i) {
+        Estimate += EstimateTessellatedPoints(i);
+    }
+    FLineScratchStats::Reserve(Tessellated, Estimate);
+    FLineScratchStats::Reserve(TessProgress, Estimate);
+
+    for (int32 i = 0; i < Points.Num(); ++i) {
+        SegmentTessIndexes[i] = Tessellated.Num();
+
+        if (i < Points.Num() - 1) {
+            TessellateSegment(i, Tessellated, TessProgress);
+        } else {
+            Tessellated.Add(Points[i]); // Last point is not a full segment
+            TessProgress.Add(0);
+        }
+    }
+    
+    // UE_LOG(LogTemp, Log, TEXT("Total length after calculate bezier: %f"), TotalLength);
+    // for (int32 i = 0; i < Points.Num(); ++i) {
+    //     UE_LOG(LogTemp, Log, TEXT("Segment %d tess index: %d"), i, SegmentTessIndexes[i]);
+    // }
+}
+
+void FBezierCalc::CalculateLengths()
+{
+    // Build the cumulative arc-length table over the tessellated points, and derive segment lengths
+    // from it. The same table serves both soft and hard-cornered lines, since a hard-cornered line
+    // is simply tessellated into its own points.
+    
+    FLineScratchStats::Reserve(TessLengths, Tessellated.Num());
+    TessLengths.SetNumUninitialized(Tessellated.Num(), false);
+
+    if (Tessellated.Num() > 0) {
+        TessLengths[0] = 0;
+    }
+    
+    for (int32 i = 1; i < Tessellated.Num(); ++i) {
+        TessLengths[i] = TessLengths[i - 1] + FVector::Dist(Tessellated[i - 1], Tessellated[i]);
+    }
+
+    CalculateSegmentLengths(0);
+}
+
+void FBezierCalc::CalculateSegmentLengths(const int32 First)
+{
+    // Segment start lengths from the point First on, and the lengths of the segments they start
+    // and end. The ones before are unchanged.
+    
+    FLineScratchStats::Reserve(SegmentLengths, Points.Num());
+    FLineScratchStats::Reserve(SegmentStartLengths, Points.Num());
+    SegmentLengths.SetNumZeroed(Points.Num(), false);
+    SegmentStartLengths.SetNumZeroed(Points.Num(), false);
+    TotalLength = 0;
+
+    if (Tessellated.Num() == 0) {
+        return;
+    }
+
+    TotalLength = TessLengths.Last() - TessLengths[0];
+
+    for (int32 i = FMath::Max(First, 0); i < Points.Num(); ++i) {
+        SegmentStartLengths[i] = TessLengths[SegmentTessIndex(i)];
+    }
+
+    for (int32 i = FMath::Max(First - 1, 0); i < Points.Num() - 1; ++i) {
+        SegmentLengths[i] = SegmentStartLengths[i + 1] - SegmentStartLengths[i];
+    }
+    SegmentLengths.Last() = 0; // Last point is not a segment.
+
+    // for (int32 i = 0; i < Points.Num(); ++i) {
+    //     UE_LOG(LogTemp, Log, TEXT("Segment %d length: %f"), i, SegmentLengths[i]);
+    // }
+}
+
+void FBezierCalc::TessellateSegment(const int32 SegmentIndex, TLineTrimArray<FVector>& TesPoints, TLineTrimArray<float>& TesProgress) const
+{
+    constexpr float NearPoint = 0.2f;
+    constexpr float FarPoint = 0.8f;
+    const float EffectiveQuality = FMath::Lerp(50.0, 0.01, (TessellationQuality));
+
+    // Subdivide with an explicit stack instead of recursion. The right half is pushed before the
+    // left half, so spans are finished in order along the segment. Each span carries its end
+    // points, so a parent's curved midpoint is reused as the boundary of both its halves. The stack
+    // never holds more than one pending span per depth level, so it fits the inline allocation.
+    
+    struct FSpan
+    {
+        float T0;
+        float T1;
+        FVector P0;
+        FVector P1;
+        int32 Depth;
+    };
+
+    TArray<FSpan, TInlineAllocator<MaxTessellationDepth + 1>> Stack;
+    Stack.Add(FSpan{0, 1, Points[SegmentIndex], Points[SegmentIndex + 1], 0});
+
+    while (Stack.Num() > 0) {
+        const FSpan Span = Stack.Pop(false);
+        const float T0 = Span.T0;
+        const float T1 = Span.T1;
+        const FVector& P0 = Span.P0;
+        const FVector& P1 = Span.P1;
+        const FVector CurvedMidPoint = EvaluateSegment(SegmentIndex, FMath::Lerp(T0, T1, 0.5f));
+
+        // Compare the curved samples against linear samples to see if the deviation is too great and we
+        // need to tessellate this segment. This is crammed into a convoluted if statement to benefit
+        // from short-circuiting. The decision can almost always be made just with the center point, but
+        // there are some cases where the center point is exactly equal to the middle of a very curved
+        // line, so we have to sample also the near and far points.
+        
+        if (
+            Span.Depth < MaxTessellationDepth && (
+                (CurvedMidPoint - FMath::Lerp(P0, P1, 0.5f)).Size() > EffectiveQuality ||
+                (EvaluateSegment(SegmentIndex, FMath::Lerp(T0, T1, NearPoint)) - FMath::Lerp(P0, P1, NearPoint)).Size() > EffectiveQuality ||
+                (EvaluateSegment(SegmentIndex, FMath::Lerp(T0, T1, FarPoint)) - FMath::Lerp(P0, P1, FarPoint)).Size() > EffectiveQuality
+            )
+        ) {
+            const float TMid = (T0 + T1) * 0.5f;
+            Stack.Add(FSpan{TMid, T1, CurvedMidPoint, P1, Span.Depth + 1});
+            Stack.Add(FSpan{T0, TMid, P0, CurvedMidPoint, Span.Depth + 1});
+        } else {
+            // Doesn't need any more tessellation.
+            TesPoints.Add(P0);
+            TesPoints.Add(CurvedMidPoint);
+            TesProgress.Add(T0);
+            TesProgress.Add((T0 + T1) * 0.5f);
+        }
+    }
+}
+
+int32 FBezierCalc::EstimateTessellatedPoints(const int32 SegmentIndex) const
+{
+    // Estimate how many points TessellateSegment() will produce, from the standard error bound for
+    // flattening a cubic: N even pieces deviate at most |B''| / (8 * N^2). The second derivative is
+    // linear, so its maximum is at one of the ends. Subdivision is binary and every finished span
+    // adds two points.
+    
+    const FBezierCoefficients& Coeffs = Coefficients[SegmentIndex];
+    const float EffectiveQuality = FMath::Lerp(50.0, 0.01, (TessellationQuality));
+    const float MaxSecondDerivative = FMath::Max((Coeffs.B * 2.0f).Size(), (Coeffs.A * 6.0f + Coeffs.B * 2.0f).Size());
+    const float Pieces = FMath::Sqrt(MaxSecondDerivative / (8.0f * EffectiveQuality));
+    const uint32 Spans = FMath::RoundUpToPowerOfTwo(FMath::Clamp(FMath::CeilToInt(Pieces), 1, 1 << MaxTessellationDepth));
+    return static_cast<int32>(Spans) * 2;
+}
+
+FVector FBezierCalc::CalculateBezierPoint(float FloatProgress)
+{
+    // UE_LOG(LogTemp, Log, TEXT("CalculateBezierPoint"));
+
+    if (Points.Num() == 0) {
+        return FVector::ZeroVector;
+    }
+
+    if (FloatProgress >= Points.Num() - 1) {
+        return Points.Last();
+    }
+    
+    FloatProgress = FMath::Clamp(FloatProgress, 0, Points.Num());
+    int32 Segment = 0;
+    float Progress = 0;
+    DecomposeFloatProgress(FloatProgress, Segment, Progress);
+
+    // Ensure the segment index is within the bounds of the calculated segments
+    if (Segment < 0 || Segment >= Coefficients.Num()) {
+        UE_LOG(LogTemp, Warning, TEXT("Segment index out of bounds"));
+        return FVector::ZeroVector; // Return a default value to avoid crashing
+    }
+
+    return EvaluateSegment(Segment, Progress);
+}
+
+FVector FBezierCalc::CalculateBezierPoint(const int32 Segment, const float Progress)
+{
+    // Same clamping as the float progress version, but without composing and decomposing the
+    // progress. Progress 1 on the last segment is the last point.
+    
+    if (Points.Num() == 0) {
+        return FVector::ZeroVector;
+    }
+
+    const int32 ClampedSegment = FMath::Max(Segment, 0);
+    const float ClampedProgress = FMath::Clamp(Progress, 0, 1);
+
+    if (ClampedSegment >= Points.Num() - 1 || (ClampedSegment == Points.Num() - 2 && ClampedProgress >= 1)) {
+        return Points.Last();
+    }
+
+    if (ClampedSegment >= Coefficients.Num()) {
+        UE_LOG(LogTemp, Warning, TEXT("Segment index out of bounds"));
+        return FVector::ZeroVector; // Return a default value to avoid crashing
+    }
+
+    return EvaluateSegment(ClampedSegment, ClampedProgress);
+}
+
+void FBezierCalc::DecomposeFloatProgress(float FloatProgress, int32& Segment, float& Progress) const
+{
+    // Splits a float progress like 1.7 into Segment = (int) 1, Progress = (float) 0.7
+    FloatProgress = FMath::Clamp(FloatProgress, 0, Points.Num());
+    float SegmentFloat = 0;
+    Progress = FMath::Modf(FloatProgress, &SegmentFloat);
+    Segment = static_cast<int32>(SegmentFloat);
+}
+
+bool FBezierCalc::ResolveFloatProgress(const float FloatProgress, int32& Segment, float& T) const
+{
+    // Like DecomposeFloatProgress(), but always lands on a calculated segment. The end of the line
+    // is the end of the last segment rather than the start of a segment that doesn't exist.
+    
+    if (Coefficients.Num() == 0) {
+        return false;
+    }
+
+    const float Clamped = FMath::Clamp(FloatProgress, 0, Coefficients.Num());
+    DecomposeFloatProgress(Clamped, Segment, T);
+    
+    if (Segment >= Coefficients.Num()) {
+        Segment = Coefficients.Num() - 1;
+        T = 1;
+    }
+    
+    return true;
+}
+
+FVector FBezierCalc::TangentDirection(const int32 Segment, const float T, const FVector& Derivative) const
+{
+    // Normalized direction of travel from the first derivative. Where the derivative vanishes
+    // (at an end with a zero-length tangent), the curve leaves along the second derivative, or
+    // arrives against it. Straight, zero-length segments fall back to the chord.
+    
+    FVector Direction = Derivative.GetSafeNormal();
+    if (!Direction.IsZero()) {
+        return Direction;
+    }
+
+    Direction = (EvaluateSegmentSecondDerivative(Segment, T) * (T < 0.5f ? 1.0f : -1.0f)).GetSafeNormal();
+    if (!Direction.IsZero()) {
+        return Direction;
+    }
+
+    return (EvaluateSegment(Segment, 1) - EvaluateSegment(Segment, 0)).GetSafeNormal();
+}
+
+FVector FBezierCalc::SlopeAtPoint(const float FloatProgress) const
+{
+    // UE_LOG(LogTemp, Log, TEXT("SlopeAtPoint"));
+
+    // Exact tangent from the first derivative of the segment.
+    
+    int32 Segment = 0;
+    float T = 0;
+    if (!ResolveFloatProgress(FloatProgress, Segment, T)) {
+        return FVector::ZeroVector;
+    }
+    
+    return TangentDirection(Segment, T, EvaluateSegmentDerivative(Segment, T));
+}
+
+FVector FBezierCalc::PerpendicularAtPoint(const float FloatProgress, const FVector& UpVector) const
+{
+    // UE_LOG(LogTemp, Log, TEXT("PerpendicularAtPoint"));
+    
+    const FVector Slope = SlopeAtPoint(FloatProgress);
+    const FVector Perpendicular = FVector::CrossProduct(Slope, UpVector).GetSafeNormal();
+    return Perpendicular;
+}
+
+FBezierFrame FBezierCalc::EvaluateFrame(const float FloatProgress, const FVector& UpVector) const
+{
+    // Position, tangent, normal and curvature in one pass, for callers that need several of them
+    // at the same point. The normal is the same as PerpendicularAtPoint().
+    
+    FBezierFrame Frame;
+    int32 Segment = 0;
+    float T = 0;
+    
+    if (!ResolveFloatProgress(FloatProgress, Segment, T)) {
+        Frame.Position = (Points.Num() > 0) ? Points[0] : FVector::ZeroVector;
+        return Frame;
+    }
+
+    const FVector Derivative = EvaluateSegmentDerivative(Segment, T);
+    const FVector SecondDerivative = EvaluateSegmentSecondDerivative(Segment, T);
+    const float Speed = Derivative.Size();
+    
+    Frame.Position = EvaluateSegment(Segment, T);
+    Frame.Tangent = TangentDirection(Segment, T, Derivative);
+    Frame.Normal = FVector::CrossProduct(Frame.Tangent, UpVector).GetSafeNormal();
+    Frame.Curvature = (Speed > UE_KINDA_SMALL_NUMBER) ? FVector::CrossProduct(Derivative, SecondDerivative).Size() / (Speed * Speed * Speed) : 0;
+    
+    return Frame;
+}
+
+void FBezierCalc::EvaluateBatch(TConstArrayView<float> FloatProgresses, FBezierSoA& OutPositions, FBezierSoA* OutTangents) const
+{
+    // Evaluates many float progresses (e.g. 1.7) at once, with the same clamping as
+    // CalculateBezierPoint() and the same tangents as SlopeAtPoint(). Output buffers are resized to
+    // match the input. The polynomial is evaluated for four parameters at a time in vector
+    // registers. The parameters can land on different segments, so the coefficients are gathered
+    // into the lanes, but sorted input mostly stays in cache.
+
+    OutPositions.SetNum(FloatProgresses.Num());
+    if (OutTangents != nullptr) {
+        OutTangents->SetNum(FloatProgresses.Num());
+    }
+
+    if (Coefficients.Num() == 0) {
+        // Zero or one point. There is no curve, just the point itself if there is one.
+        const FVector Position = (Points.Num() > 0) ? Points[0] : FVector::ZeroVector;
+        for (int32 i = 0; i < FloatProgresses.Num(); ++i) {
+            OutPositions.Set(i, Position);
+            if (OutTangents != nullptr) {
+                OutTangents->Set(i, FVector::ZeroVector);
+            }
+        }
+        return;
+    }
+
+    constexpr int32 Lanes = 4;
+    const VectorRegister4Double Two = MakeVectorRegisterDouble(2.0, 2.0, 2.0, 2.0);
+    const VectorRegister4Double Three = MakeVectorRegisterDouble(3.0, 3.0, 3.0, 3.0);
+    const VectorRegister4Double MinLengthSquared = MakeVectorRegisterDouble(UE_SMALL_NUMBER, UE_SMALL_NUMBER, UE_SMALL_NUMBER, UE_SMALL_NUMBER);
+
+    int32 i = 0;
+    for (; i + Lanes <= FloatProgresses.Num(); i += Lanes) {
+        int32 Segments[Lanes];
+        double Ts[Lanes];
+
+        for (int32 Lane = 0; Lane < Lanes; ++Lane) {
+            float T = 0;
+            ResolveFloatProgress(FloatProgresses[i + Lane], Segments[Lane], T);
+            Ts[Lane] = T;
+        }
+
+        const FBezierCoefficients& C0 = Coefficients[Segments[0]];
+        const FBezierCoefficients& C1 = Coefficients[Segments[1]];
+        const FBezierCoefficients& C2 = Coefficients[Segments[2]];
+        const FBezierCoefficients& C3 = Coefficients[Segments[3]];
+
+        #define LR_GATHER(Coeff, Axis) MakeVectorRegisterDouble(C0.Coeff.Axis, C1.Coeff.Axis, C2.Coeff.Axis, C3.Coeff.Axis)
+        const VectorRegister4Double AX = LR_GATHER(A, X), AY = LR_GATHER(A, Y), AZ = LR_GATHER(A, Z);
+        const VectorRegister4Double BX = LR_GATHER(B, X), BY = LR_GATHER(B, Y), BZ = LR_GATHER(B, Z);
+        const VectorRegister4Double CX = LR_GATHER(C, X), CY = LR_GATHER(C, Y), CZ = LR_GATHER(C, Z);
+        const VectorRegister4Double DX = LR_GATHER(D, X), DY = LR_GATHER(D, Y), DZ = LR_GATHER(D, Z);
+        #undef LR_GATHER
+
+        const VectorRegister4Double T = VectorLoad(Ts);
+
+        // Horner's rule, ((A*t + B)*t + C)*t + D.
+        VectorStore(VectorMultiplyAdd(VectorMultiplyAdd(VectorMultiplyAdd(AX, T, BX), T, CX), T, DX), OutPositions.X.GetData() + i);
+        VectorStore(VectorMultiplyAdd(VectorMultiplyAdd(VectorMultiplyAdd(AY, T, BY), T, CY), T, DY), OutPositions.Y.GetData() + i);
+        VectorStore(VectorMultiplyAdd(VectorMultiplyAdd(VectorMultiplyAdd(AZ, T, BZ), T, CZ), T, DZ), OutPositions.Z.GetData() + i);
+
+        if (OutTangents == nullptr) {
+            continue;
+        }
+
+        // First derivative, (3A*t + 2B)*t + C, then normalized.
+        const VectorRegister4Double ThreeT = VectorMultiply(Three, T);
+        const VectorRegister4Double VX = VectorMultiplyAdd(VectorMultiplyAdd(AX, ThreeT, VectorMultiply(BX, Two)), T, CX);
+        const VectorRegister4Double VY = VectorMultiplyAdd(VectorMultiplyAdd(AY, ThreeT, VectorMultiply(BY, Two)), T, CY);
+        const VectorRegister4Double VZ = VectorMultiplyAdd(VectorMultiplyAdd(AZ, ThreeT, VectorMultiply(BZ, Two)), T, CZ);
+        const VectorRegister4Double LengthSquared = VectorMultiplyAdd(VX, VX, VectorMultiplyAdd(VY, VY, VectorMultiply(VZ, VZ)));
+        const VectorRegister4Double Length = VectorSqrt(VectorMax(LengthSquared, MinLengthSquared));
+
+        VectorStore(VectorDivide(VX, Length), OutTangents->X.GetData() + i);
+        VectorStore(VectorDivide(VY, Length), OutTangents->Y.GetData() + i);
+        VectorStore(VectorDivide(VZ, Length), OutTangents->Z.GetData() + i);
+
+        // Lanes where the derivative vanishes (cusps, coincident tangents) take the scalar fallback.
+        if (VectorMaskBits(VectorCompareLT(LengthSquared, MinLengthSquared)) != 0) {
+            for (int32 Lane = 0; Lane < Lanes; ++Lane) {
+                const FVector Derivative = EvaluateSegmentDerivative(Segments[Lane], Ts[Lane]);
+                if (Derivative.SizeSquared() < UE_SMALL_NUMBER) {
+                    OutTangents->Set(i + Lane, TangentDirection(Segments[Lane], Ts[Lane], Derivative));
+                }
+            }
+        }
+    }
+
+    // Remainder that doesn't fill a whole register.
+    EvaluateBatchScalar(FloatProgresses, i, OutPositions, OutTangents);
+}
+
+void FBezierCalc::EvaluateBatchScalar(TConstArrayView<float> FloatProgresses, const int32 Begin, FBezierSoA& OutPositions, FBezierSoA* OutTangents) const
+{
+    // Plain version of EvaluateBatch() for the tail. Buffers must already be sized.
+    
+    for (int32 i = Begin; i < FloatProgresses.Num(); ++i) {
+        int32 Segment = 0;
+        float T = 0;
+        ResolveFloatProgress(FloatProgresses[i], Segment, T);
+
+        OutPositions.Set(i, EvaluateSegment(Segment, T));
+        if (OutTangents != nullptr) {
+            OutTangents->Set(i, TangentDirection(Segment, T, EvaluateSegmentDerivative(Segment, T)));
+        }
+    }
+}
+
+FVector FBezierCalc::CalculateLinearPoint(const float Progress) const
+{
+    // Only works when bezier is calculated. First early exits.
+
+    if (Points.Num() == 0) {
+        return FVector::ZeroVector;
+    } else if (Points.Num() == 1 || Tessellated.Num() < 2) {
+        return Points[0];
+    }
+
+    if (Progress <= 0) {
+        return Points[0];
+    } else if (Progress >= 1) {
+        return Points[Points.Num() - 1];
+    }
+
+    // Walk the tessellated polyline rather than the bezier parameter, so that speed is constant
+    // also within curved segments.
+    
+    int32 TessIndex = 0;
+    float Alpha = 0;
+    LocateDistance(Progress * TotalLength, TessIndex, Alpha);
+    return FMath::Lerp(Tessellated[TessIndex], Tessellated[TessIndex + 1], Alpha);
+}
+
+FVector FBezierCalc::SlopeAtLinearPoint(const float Progress) const
+{
+    // Direction of travel at a linear progress. This is the direction of the tessellated fragment
+    // we're on, which matches what CalculateLinearPoint() moves along.
+    
+    if (Tessellated.Num() < 2) {
+        return FVector::ZeroVector;
+    }
+
+    int32 TessIndex = 0;
+    float Alpha = 0;
+    LocateDistance(FMath::Clamp(Progress, 0, 1) * TotalLength, TessIndex, Alpha);
+    return (Tessellated[TessIndex + 1] - Tessellated[TessIndex]).GetSafeNormal();
+}
+
+float FBezierCalc::DistanceAtFloatProgress(float FloatProgress) const
+{
+    // Converts a bezier float progress (e.g. 1.7) to a distance along the line.
+    
+    if (Tessellated.Num() < 2) {
+        return 0;
+    }
+    
+    FloatProgress = FMath::Clamp(FloatProgress, 0, Points.Num() - 1);
+    int32 Segment = 0;
+    float Progress = 0;
+    DecomposeFloatProgress(FloatProgress, Segment, Progress);
+
+    if (Segment >= Points.Num() - 1) {
+        return TotalLength;
+    }
+
+    // Find the last tessellated point in the segment that is at or before the progress. The
+    // segment's end point belongs to the next segment, and has progress 1 from this side.
+    
+    const int32 First = SegmentTessIndex(Segment);
+    const int32 End = SegmentTessIndex(Segment + 1);
+    const int32 TessIndex = FMath::Clamp(First + Algo::UpperBound(MakeArrayView(&TessProgress[First], End - First), Progress) - 1, First, End - 1);
+    
+    const float FromProgress = TessProgress[TessIndex];
+    const float ToProgress = (TessIndex + 1 < End) ? TessProgress[TessIndex + 1] : 1.0f;
+    const float Alpha = (ToProgress > FromProgress) ? (Progress - FromProgress) / (ToProgress - FromProgress) : 0.0f;
+    
+    return FMath::Lerp(TessLengths[TessIndex], TessLengths[TessIndex + 1], Alpha) - TessLengths[0];
+}
+
+float FBezierCalc::FloatProgressAtDistance(const float Distance) const
+{
+    // Converts a distance along the line to a bezier float progress (e.g. 1.7).
+    
+    if (Tessellated.Num() < 2) {
+        return 0;
+    }
+
+    int32 TessIndex = 0;
+    float Alpha = 0;
+    LocateDistance(Distance, TessIndex, Alpha);
+
+    const int32 Segment = SegmentOfTessIndex(TessIndex);
+    const float FromProgress = TessProgress[TessIndex];
+    const float ToProgress = (TessIndex + 1 < SegmentTessIndex(Segment + 1)) ? TessProgress[TessIndex + 1] : 1.0f;
+    
+    return Segment + FMath::Lerp(FromProgress, ToProgress, Alpha);
+}
+
+void FBezierCalc::LocateDistance(const float Distance, int32& TessIndex, float& Alpha) const
+{
+    // Binary search the arc-length table for the tessellated fragment containing the distance.
+    // Returns the index of the fragment's first point, and the fraction along the fragment.
+
+    const float Length = TessLengths[0] + Distance;
+    TessIndex = FMath::Clamp(Algo::UpperBound(TessLengths, Length) - 1, 0, Tessellated.Num() - 2);
+    
+    const float FragmentLength = TessLengths[TessIndex + 1] - TessLengths[TessIndex];
+    Alpha = (FragmentLength > 0) ? FMath::Clamp((Length - TessLengths[TessIndex]) / FragmentLength, 0, 1) : 0;
+}
+
+int32 FBezierCalc::SegmentOfTessIndex(const int32 TessIndex) const
+{
+    // Segments start at strictly increasing tessellated indexes. Clamped so that the last point
+    // counts as the end of the last segment.
+    
+    return FMath::Clamp(Algo::UpperBound(SegmentTessIndexes, TessIndexBase + TessIndex) - 1, 0, Points.Num() - 2);
+}
+
+//
+// NEAREST POINT
+//
+
+namespace
+{
+    // Distance measures for FBezierCalc::FindNearest(). Each gives a lower bound on the squared
+    // distance to anything inside a box, the squared distance to a point on the curve, and the
+    // first and second derivatives of half that squared distance along the curve for Newton's
+    // method.
+
+    struct FNearestPointMetric
+    {
+        FVector Point;
+
+        double LowerBoundSquared(const FBox& Bounds) const
+        {
+            return Bounds.ComputeSquaredDistanceToPoint(Point);
+        }
+
+        double DistanceSquared(const FVector& Position) const
+        {
+            return FVector::DistSquared(Position, Point);
+        }
+
+        void Derivatives(const FVector& Position, const FVector& Velocity, const FVector& Acceleration, double& OutFirst, double& OutSecond) const
+        {
+            const FVector Offset = Position - Point;
+            OutFirst = FVector::DotProduct(Offset, Velocity);
+            OutSecond = FVector::DotProduct(Offset, Acceleration) + Velocity.SizeSquared();
+        }
+    };
+
+    struct FNearestRayMetric
+    {
+        FVector Origin;
+        FVector Direction; // Normalized.
+
+        FVector Perpendicular(const FVector& Vector) const
+        {
+            return Vector - Direction * FVector::DotProduct(Vector, Direction);
+        }
+
+        double LowerBoundSquared(const FBox& Bounds) const
+        {
+            // The bounding sphere of the box is cheaper to test against a ray than the box.
+            const double Distance = FMath::Max(FMath::Sqrt(DistanceSquared(Bounds.GetCenter())) - Bounds.GetExtent().Size(), 0.0);
+            return Distance * Distance;
+        }
+
+        double DistanceSquared(const FVector& Position) const
+        {
+            // Points behind the origin are closest to the origin itself.
+            const FVector Offset = Position - Origin;
+            return (FVector::DotProduct(Offset, Direction) > 0) ? Perpendicular(Offset).SizeSquared() : Offset.SizeSquared();
+        }
+
+        void Derivatives(const FVector& Position, const FVector& Velocity, const FVector& Acceleration, double& OutFirst, double& OutSecond) const
+        {
+            const FVector Offset = Position - Origin;
+            if (FVector::DotProduct(Offset, Direction) > 0) {
+                const FVector Across = Perpendicular(Offset);
+                OutFirst = FVector::DotProduct(Across, Velocity);
+                OutSecond = FVector::DotProduct(Across, Acceleration) + Perpendicular(Velocity).SizeSquared();
+            } else {
+                OutFirst = FVector::DotProduct(Offset, Velocity);
+                OutSecond = FVector::DotProduct(Offset, Acceleration) + Velocity.SizeSquared();
+            }
+        }
+    };
+}
+
+template <typename FMetric>
+FBezierNearestResult FBezierCalc::FindNearest(const FMetric& Metric) const
+{
+    // Segments whose control point bounds are further away than the best match so far are
+    // skipped. The rest are refined with Newton's method, starting from the closest tessellated
+    // point. The segment with the closest bounds goes first, so that a good match is known early.
+    
+    FBezierNearestResult Result;
+
+    if (Coefficients.Num() == 0 || SegmentBounds.Num() != Coefficients.Num() || SegmentTessIndexes.Num() != Points.Num()) {
+        if (Points.Num() == 1) {
+            Result.Valid = true;
+            Result.Position = Points[0];
+            Result.DistanceToCurve = FMath::Sqrt(Metric.DistanceSquared(Points[0]));
+        }
+        return Result;
+    }
+
+    double BestSquared = std::numeric_limits<double>::max();
+    int32 BestSegment = 0;
+    float BestProgress = 0;
+
+    const auto Refine = [&](const int32 Segment) {
+        // Start from the closest tessellated point in the segment, or its end.
+        float T = 1;
+        double TSquared = Metric.DistanceSquared(EvaluateSegment(Segment, 1));
+        
+        for (int32 i = SegmentTessIndex(Segment); i < SegmentTessIndex(Segment + 1); ++i) {
+            const double DistanceSquared = Metric.DistanceSquared(Tessellated[i]);
+            if (DistanceSquared < TSquared) {
+                TSquared = DistanceSquared;
+                T = TessProgress[i];
+            }
+        }
+
+        for (int32 Iteration = 0; Iteration < MaxNewtonIterations; ++Iteration) {
+            double First = 0;
+            double Second = 0;
+            Metric.Derivatives(EvaluateSegment(Segment, T), EvaluateSegmentDerivative(Segment, T), EvaluateSegmentSecondDerivative(Segment, T), First, Second);
+            if (Second <= 0) {
+                // Not heading for a minimum.
+                break;
+            }
+
+            const float NextT = FMath::Clamp(T - static_cast<float>(First / Second), 0.0f, 1.0f);
+            const double NextSquared = Metric.DistanceSquared(EvaluateSegment(Segment, NextT));
+            if (NextSquared > TSquared) {
+                break;
+            }
+
+            const bool Converged = FMath::Abs(NextT - T) < 1.e-6f;
+            T = NextT;
+            TSquared = NextSquared;
+            if (Converged) {
+                break;
+            }
+        }
+
+        if (TSquared < BestSquared) {
+            BestSquared = TSquared;
+            BestSegment = Segment;
+            BestProgress = T;
+        }
+    };
+
+    int32 FirstSegment = 0;
+    double FirstBound = std::numeric_limits<double>::max();
+    for (int32 Segment = 0; Segment < SegmentBounds.Num(); ++Segment) {
+        const double Bound = Metric.LowerBoundSquared(SegmentBounds[Segment]);
+        if (Bound < FirstBound) {
+            FirstBound = Bound;
+            FirstSegment = Segment;
+        }
+    }
+
+    Refine(FirstSegment);
+
+    for (int32 Segment = 0; Segment < SegmentBounds.Num(); ++Segment) {
+        if (Segment != FirstSegment && Metric.LowerBoundSquared(SegmentBounds[Segment]) < BestSquared) {
+            Refine(Segment);
+        }
+    }
+
+    Result.Valid = true;
+    Result.Position = EvaluateSegment(BestSegment, BestProgress);
+    Result.DistanceToCurve = FMath::Sqrt(BestSquared);
+    Result.Distance = DistanceAtFloatProgress(BestSegment + BestProgress);
+
+    // The end of a segment is the start of the next, except at the end of the line.
+    if (BestProgress >= 1 && BestSegment < Coefficients.Num() - 1) {
+        ++BestSegment;
+        BestProgress = 0;
+    }
+    Result.Segment = BestSegment;
+    Result.Progress = BestProgress;
+    
+    return Result;
+}
+
+FBezierNearestResult FBezierCalc::FindNearestPoint(const FVector& Point) const
+{
+    // Closest point on the curve to a point in world space, e.g. for snapping to the line.
+    
+    return FindNearest(FNearestPointMetric{Point});
+}
+
+FBezierNearestResult FBezierCalc::FindNearestToRay(const FVector& Origin, const FVector& Direction) const
+{
+    // Closest point on the curve to a ray in world space, e.g. for picking in 3D. DistanceToCurve
+    // is how far the ray passes from the curve.
+    
+    const FVector Normalized = Direction.GetSafeNormal();
+    if (Normalized.IsZero()) {
+        return FBezierNearestResult{};
+    }
+    
+    return FindNearest(FNearestRayMetric{Origin, Normalized});
+}
+
+//
+// HIT DETECTION
+//
+
+FHitDetectionResult FBezierCalc::HitDetectPoints(FLineHitQueryContext& Context, const FVector2D& HitPos, const float MaxDistance)
+{
+    // Closest control point on screen, if closer than MaxDistance. Only the points in parts of the
+    // line that could be that close are projected.
+    
+    if (!PointBvh.IsBuilt()) {
+        PointBvh.Build(Points, false);
+    }
+
+    FHitDetectionResult Result;
+    Result.Distance = MaxDistance;
+
+    PointBvh.Query(Context, HitPos, Result.Distance, [&](const int32 First, const int32 Num) {
+        Context.ProjectToScratch(MakeArrayView(Points.GetData() + First, Num));
+        
+        for (int32 i = 0; i < Num; ++i) {
+            const float Distance = FVector2D::Distance(HitPos, Context.ScreenPoints[i]);
+            
+            if (Context.OnScreen[i] && Distance < Result.Distance) {
+                // Result.IsOnScreen = true;
+                Result.Segment = First + i;
+                Result.Distance = Distance;
+                Result.Valid = true;
+            }
+        }
+    });
+
+    if (!Result.Valid) {
+        return FHitDetectionResult{};
+    }
+    
+    return MoveTemp(Result);
+}
+
+FHitDetectionResult FBezierCalc::HitDetectSpline(FLineHitQueryContext& Context, const FVector2D& HitPos, const float MaxDistance)
+{
+    // Closest point on the tessellated line on screen, if closer than MaxDistance. Only the
+    // fragments in parts of the line that could be that close are projected.
+
+    if (!SplineBvh.IsBuilt()) {
+        SplineBvh.Build(Tessellated, true);
+    }
+
+    FHitDetectionResult Result;
+    Result.Distance = MaxDistance;
+
+    SplineBvh.Query(Context, HitPos, Result.Distance, [&](const int32 First, const int32 Num) {
+        HitDetectFragments(Context, HitPos, First, First + Num, Result);
+    });
+
+    if (!Result.Valid) {
+        return FHitDetectionResult{};
+    }
+    
+    return MoveTemp(Result);
+}
+
+void FBezierCalc::HitDetectFragments(FLineHitQueryContext& Context, const FVector2D& HitPos, const int32 First, const int32 End, FHitDetectionResult& Result) const
+{
+    // Tests the fragments from First up to (not including) End, each going from a tessellated
+    // point to the next, and updates Result if any of them are closer. Fragments that reach behind
+    // the camera have no meaningful screen position, and are skipped.
+    
+    // Convert line to screen coordinates
+    
+    Context.ProjectToScratch(MakeArrayView(Tessellated.GetData() + First, End - First + 1));
+    const TArray<FVector2D>& ScreenLinePoints = Context.ScreenPoints;
+    const TArray<bool>& OnScreen = Context.OnScreen;
+
+    int32 Segment = SegmentOfTessIndex(First);
+    
+    for (int32 i = First; i < End; ++i) {
+        while (i >= SegmentTessIndex(Segment + 1)) {
+            ++Segment;
+        }
+
+        if (!OnScreen[i - First] || !OnScreen[i - First + 1]) {
+            continue;
+        }
+        
+        // Prepare 2D values
+        const FVector2D& FromScreenPoint = ScreenLinePoints[i - First];
+        const FVector2D& ToScreenPoint = ScreenLinePoints[i - First + 1];
+        const FVector2D ScreenLineVector = ToScreenPoint - FromScreenPoint;
+        const FVector2D HitPointVector = HitPos - FromScreenPoint;
+
+        // Project PointVector onto LineVector
+        const float LineLengthSquared = ScreenLineVector.SizeSquared();
+        const float Projection = FVector2D::DotProduct(HitPointVector, ScreenLineVector) / LineLengthSquared;
+
+        // Clamp the projection value to the range [0, 1] to stay on the line segment
+        const float FragmentProgress = FMath::Clamp(Projection, 0.0f, 1.0f);
+
+        // Find the closest point on the line
+        const FVector2D ClosestPoint = FromScreenPoint + ScreenLineVector * FragmentProgress;
+
+        // Calculate distance and position on line
+        const float DistanceToPoint = (HitPos - ClosestPoint).Size();
+
+        if (DistanceToPoint < Result.Distance) {
+            // 3D length along the segment, from the arc-length table.
+            const float FragmentLength = TessLengths[i + 1] - TessLengths[i];
+            const float LengthAlongLine = TessLengths[i] - SegmentStartLengths[Segment] + FragmentProgress * FragmentLength;
+            Result.Progress = LengthAlongLine / SegmentLengths[Segment];
+            Result.Distance = DistanceToPoint;
+            Result.Segment = Segment;
+            Result.Valid = true;
+
+            if (Result.Progress >= 1) {
+                Result.Progress -= 1;
+                Result.Segment += 1;
+            }
+        }
+    }
+}
+
+//
+// UTILITY
+//
+
+void FBezierCalc::DumpTessellated() const
+{
+    UE_LOG(LogTemp, Log, TEXT("*************** DUMP TESSELLATED ***************"));
+
+    if (Tessellated.Num() == 0)
+        return;
+
+    FVector PreviousPoint = FVector::ZeroVector;
+    float TotalDist = 0;
+    
+    for (int i = 0; i < Tessellated.Num(); ++i) {
+        const FVector& CurrentPoint = Tessellated[i];
+        const float Distance = (i == 0) ? 0 : FVector::Dist(PreviousPoint, CurrentPoint);
+        TotalDist += Distance;
+
+        UE_LOG(LogTemp, Log, TEXT("Point %d: (%s), Distance from Previous: %f"), i, *CurrentPoint.ToString(), Distance);
+
+        PreviousPoint = CurrentPoint;
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("Total length: %f, Total tess points: %d"), TotalDist, Tessellated.Num());
+}
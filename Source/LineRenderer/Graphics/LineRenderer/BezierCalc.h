@@ -1,52 +1,221 @@
-// Copyright Hollywood Camera Work
-
-#pragma once
-
-#include <tuple>
-#include <limits>
-
-#include "LineRendererIncludes.h"
-
-#include "CoreMinimal.h"
-
-class LINERENDERER_API FBezierCalc
-{
-	// METHODS
-
-	public: void Calculate();
-	private: void CalculateTangents();
-	private: void CalculateBezier();
-	private: void TessellateSegment(const int32 SegmentIndex, const float T0, const FVector& P0, const float T1, const FVector& P1, TArray<FVector>& TesPoints);
-	public: FVector CalculateBezierPoint(const int32 Segment, const float Progress);
-	public: FVector CalculateBezierPoint(float FloatProgress);
-	public: void DecomposeFloatProgress(float FloatProgress, int32& Segment, float& Progress) const;
-	public: FVector SlopeAtPoint(float FloatProgress);
-	public: FVector PerpendicularAtPoint(const float FloatProgress, const FVector& UpVector);
-	public: FVector CalculateLinearPoint(float Progress);
-	public: FHitDetectionResult HitDetectPoints(const APlayerController* Player, const FVector2D& HitPos);
-	public: FHitDetectionResult HitDetectSpline(const APlayerController* Player, const FVector2D& HitPos);
-	public: void DumpTessellated() const;
-
-	// PROPERTIES
-
-	// Raw points and settings copied from outside.
-	public: TArray<FVector> Points;
-	public: bool HardCorners = false;
-	public: float TangentStrength = 0.3; // In fraction of a segment. Must not be greater than 0.5.
-	public: float TessellationQuality = 0.95;
-
-	// DERIVED
-
-	// Tangents are automatically created for a smooth line through the points.
-	private: TArray<FVector> InTangents;
-	private: TArray<FVector> OutTangents;
-	// Tessellated points go into a single array. SegmentIndexes are where segments start in this
-	// array. Segment lengths the length of each segment.
-	public: TArray<FVector> Tessellated;
-	public: TArray<int32> SegmentTessIndexes;
-	public: TArray<float> SegmentLengths;
-	public: TArray<float> SegmentStartLengths;
-	public: float TotalLength = 0;
-	
-	// PRIVATE PROPERTIES
-};
+// Copyright Hollywood Camera Work
+
+#pragma once
+
+#include <tuple>
+#include <limits>
+
+#include "LineRendererIncludes.h"
+#include "LineBvh.h"
+#include "LineScratchStats.h"
+#include "LineTrimArray.h"
+
+#include "CoreMinimal.h"
+
+class FLineHitQueryContext;
+
+// Range of tessellated points replaced by a partial recalculation. The old points from First up
+// to (not including) OldEnd were replaced by the new points from First up to NewEnd. If points
+// were trimmed off the front of the line, the first Trimmed tessellated points were removed before
+// that, and the new first segment was tessellated again, replacing the points up to TrimOldEnd
+// with the points up to TrimNewEnd. First, OldEnd and NewEnd count from after the trim.
+struct FTessellationSplice
+{
+	int32 Trimmed = 0;
+	int32 TrimOldEnd = 0;
+	int32 TrimNewEnd = 0;
+	int32 First = 0;
+	int32 OldEnd = 0;
+	int32 NewEnd = 0;
+};
+
+// Power-basis form of one cubic segment, evaluated as ((A*t + B)*t + C)*t + D.
+struct FBezierCoefficients
+{
+	FVector A = FVector::ZeroVector;
+	FVector B = FVector::ZeroVector;
+	FVector C = FVector::ZeroVector;
+	FVector D = FVector::ZeroVector;
+};
+
+// Position and orientation at a point on the bezier, from FBezierCalc::EvaluateFrame().
+struct FBezierFrame
+{
+	FVector Position = FVector::ZeroVector;
+	FVector Tangent = FVector::ZeroVector; // Normalized direction of travel.
+	FVector Normal = FVector::ZeroVector; // Normalized, perpendicular to the tangent and the up vector.
+	float Curvature = 0; // One over the radius of the curve at this point.
+};
+
+// Closest point on the bezier to a point or a ray, from FBezierCalc::FindNearestPoint() and
+// FindNearestToRay().
+struct FBezierNearestResult
+{
+	bool Valid = false;
+	int32 Segment = 0;
+	float Progress = 0; // Exact bezier progress within the segment.
+	float Distance = 0; // Arc-length distance along the line.
+	float DistanceToCurve = 0; // Distance from the point or ray to the curve.
+	FVector Position = FVector::ZeroVector;
+};
+
+// Structure-of-arrays buffer of vectors for FBezierCalc::EvaluateBatch(). Owned by the caller, so it
+// can be kept around and reused without reallocating.
+struct FBezierSoA
+{
+	TArray<double> X;
+	TArray<double> Y;
+	TArray<double> Z;
+
+	void SetNum(const int32 Num)
+	{
+		if (Num > X.Max()) {
+			FLineScratchStats::CountAllocation();
+		}
+		X.SetNum(Num, false);
+		Y.SetNum(Num, false);
+		Z.SetNum(Num, false);
+	}
+
+	int32 Num() const
+	{
+		return X.Num();
+	}
+
+	FVector Get(const int32 Index) const
+	{
+		return FVector(X[Index], Y[Index], Z[Index]);
+	}
+
+	void Set(const int32 Index, const FVector& Value)
+	{
+		X[Index] = Value.X;
+		Y[Index] = Value.Y;
+		Z[Index] = Value.Z;
+	}
+};
+
+class LINERENDERER_API FBezierCalc
+{
+	// METHODS
+
+	public: void Calculate();
+	public: bool CalculateRange(const int32 FirstPoint, const int32 LastPoint, FTessellationSplice& OutSplice);
+	public: bool AppendRange(const int32 NumAppended, FTessellationSplice& OutSplice);
+	public: bool TrimFront(const int32 NumTrimmed, FTessellationSplice& OutSplice);
+	private: bool MatchesCalculation(const int32 NumPoints) const;
+	private: void SpliceRange(const int32 FirstPoint, const int32 LastPoint, FTessellationSplice& OutSplice);
+	private: void CalculateTangents();
+	private: void CalculateTangentRange(const int32 First, const int32 Last);
+	private: void CalculateCoefficients(const int32 First, const int32 Last);
+	private: void CalculateBezier();
+	private: void CalculateLengths();
+	private: void CalculateSegmentLengths(const int32 First);
+	private: void TessellateSegment(const int32 SegmentIndex, TLineTrimArray<FVector>& TesPoints, TLineTrimArray<float>& TesProgress) const;
+	private: int32 EstimateTessellatedPoints(const int32 SegmentIndex) const;
+	public: FVector CalculateBezierPoint(const int32 Segment, const float Progress);
+	public: FVector CalculateBezierPoint(float FloatProgress);
+	public: FORCEINLINE FVector EvaluateSegment(const int32 Segment, const float T) const;
+	public: FORCEINLINE FVector EvaluateSegmentDerivative(const int32 Segment, const float T) const;
+	public: FORCEINLINE FVector EvaluateSegmentSecondDerivative(const int32 Segment, const float T) const;
+	public: FORCEINLINE int32 SegmentTessIndex(const int32 Segment) const;
+	public: void DecomposeFloatProgress(float FloatProgress, int32& Segment, float& Progress) const;
+	private: bool ResolveFloatProgress(const float FloatProgress, int32& Segment, float& T) const;
+	private: FVector TangentDirection(const int32 Segment, const float T, const FVector& Derivative) const;
+	public: FVector SlopeAtPoint(float FloatProgress) const;
+	public: FVector PerpendicularAtPoint(const float FloatProgress, const FVector& UpVector) const;
+	public: FBezierFrame EvaluateFrame(const float FloatProgress, const FVector& UpVector) const;
+	public: void EvaluateBatch(TConstArrayView<float> FloatProgresses, FBezierSoA& OutPositions, FBezierSoA* OutTangents = nullptr) const;
+	private: void EvaluateBatchScalar(TConstArrayView<float> FloatProgresses, const int32 Begin, FBezierSoA& OutPositions, FBezierSoA* OutTangents) const;
+	public: FVector CalculateLinearPoint(float Progress) const;
+	public: FVector SlopeAtLinearPoint(float Progress) const;
+	public: float DistanceAtFloatProgress(float FloatProgress) const;
+	public: float FloatProgressAtDistance(float Distance) const;
+	private: void LocateDistance(const float Distance, int32& TessIndex, float& Alpha) const;
+	private: int32 SegmentOfTessIndex(const int32 TessIndex) const;
+	public: FBezierNearestResult FindNearestPoint(const FVector& Point) const;
+	public: FBezierNearestResult FindNearestToRay(const FVector& Origin, const FVector& Direction) const;
+	private: template <typename FMetric> FBezierNearestResult FindNearest(const FMetric& Metric) const;
+	public: FHitDetectionResult HitDetectPoints(FLineHitQueryContext& Context, const FVector2D& HitPos, const float MaxDistance = std::numeric_limits<float>::max());
+	public: FHitDetectionResult HitDetectSpline(FLineHitQueryContext& Context, const FVector2D& HitPos, const float MaxDistance = std::numeric_limits<float>::max());
+	private: void HitDetectFragments(FLineHitQueryContext& Context, const FVector2D& HitPos, const int32 First, const int32 End, FHitDetectionResult& Result) const;
+	public: void DumpTessellated() const;
+
+	// PROPERTIES
+
+	// Raw points and settings copied from outside.
+	public: TLineTrimArray<FVector> Points;
+	public: bool HardCorners = false;
+	public: float TangentStrength = 0.3; // In fraction of a segment. Must not be greater than 0.5.
+	public: float TessellationQuality = 0.95;
+	// Hard limit on how many times a single segment can be halved while tessellating.
+	public: static constexpr int32 MaxTessellationDepth = 16;
+	// Newton steps when refining nearest point queries. It usually converges in two or three.
+	public: static constexpr int32 MaxNewtonIterations = 8;
+
+	// DERIVED
+
+	// Tangents are automatically created for a smooth line through the points.
+	private: TLineTrimArray<FVector> InTangents;
+	private: TLineTrimArray<FVector> OutTangents;
+	// Per-segment polynomial coefficients, built from points and tangents. Hard-cornered lines get
+	// straight segments.
+	private: TLineTrimArray<FBezierCoefficients> Coefficients;
+	// Bounds of each segment's control points, which the segment never leaves.
+	private: TLineTrimArray<FBox> SegmentBounds;
+	// Tessellated points go into a single array. SegmentIndexes are where segments start in this
+	// array, offset by TessIndexBase, so read them with SegmentTessIndex(). Segment lengths the
+	// length of each segment.
+	public: TLineTrimArray<FVector> Tessellated;
+	// Bezier progress (0-1 within its segment) and cumulative arc-length of each tessellated point.
+	// Together they form the lookup table for linear (constant speed) queries. The arc-lengths start
+	// at 0 after a full calculation, and keep their values when the front of the line is trimmed,
+	// so the distance along the line is TessLengths[i] - TessLengths[0]. SegmentStartLengths are on
+	// the same scale.
+	public: TLineTrimArray<float> TessProgress;
+	public: TLineTrimArray<float> TessLengths;
+	public: TLineTrimArray<int32> SegmentTessIndexes;
+	public: TLineTrimArray<float> SegmentLengths;
+	public: TLineTrimArray<float> SegmentStartLengths;
+	public: float TotalLength = 0;
+	
+	// PRIVATE PROPERTIES
+
+	// Scratch buffers for CalculateRange(), kept to avoid reallocating on every edit.
+	private: TLineTrimArray<FVector> SpliceTessellated;
+	private: TLineTrimArray<float> SpliceProgress;
+	// Net number of tessellated points trimmed off the front since the last full calculation.
+	private: int32 TessIndexBase = 0;
+	// Hit detection hierarchies over the points and the tessellated line. Built on first use after
+	// each calculation.
+	private: FLineBvh PointBvh;
+	private: FLineBvh SplineBvh;
+};
+
+FORCEINLINE FVector FBezierCalc::EvaluateSegment(const int32 Segment, const float T) const
+{
+	// Fast path for callers that already know the segment and have T within 0 to 1. No clamping or
+	// bounds checking.
+	const FBezierCoefficients& Coeffs = Coefficients[Segment];
+	return ((Coeffs.A * T + Coeffs.B) * T + Coeffs.C) * T + Coeffs.D;
+}
+
+FORCEINLINE FVector FBezierCalc::EvaluateSegmentDerivative(const int32 Segment, const float T) const
+{
+	// First derivative (velocity) of the segment, 3At^2 + 2Bt + C. Same rules as EvaluateSegment().
+	const FBezierCoefficients& Coeffs = Coefficients[Segment];
+	return (Coeffs.A * (3.0f * T) + Coeffs.B * 2.0f) * T + Coeffs.C;
+}
+
+FORCEINLINE FVector FBezierCalc::EvaluateSegmentSecondDerivative(const int32 Segment, const float T) const
+{
+	// Second derivative (acceleration) of the segment, 6At + 2B. Same rules as EvaluateSegment().
+	const FBezierCoefficients& Coeffs = Coefficients[Segment];
+	return Coeffs.A * (6.0f * T) + Coeffs.B * 2.0f;
+}
+
+FORCEINLINE int32 FBezierCalc::SegmentTessIndex(const int32 Segment) const
+{
+	// Where the segment starts in Tessellated.
+	return SegmentTessIndexes[Segment] - TessIndexBase;
+}
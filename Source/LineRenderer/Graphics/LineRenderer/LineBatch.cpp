@@ -0,0 +1,17 @@
+﻿// Copyright Hollywood Camera Work
+
+#include "LineBatch.h"
+#include "LineBatchComponent.h"
+
+ALineBatch::ALineBatch()
+{
+    PrimaryActorTick.bCanEverTick = false;
+
+    Batch = CreateDefaultSubobject<ULineBatchComponent>(TEXT("Batch"));
+    RootComponent = Batch;
+}
+
+ULineBatchComponent* ALineBatch::GetBatch() const
+{
+    return Batch;
+}
@@ -0,0 +1,29 @@
+﻿// Copyright Hollywood Camera Work
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "LineBatch.generated.h"
+
+class ULineBatchComponent;
+
+// Actor holding a ULineBatchComponent, for placing a batch of lines in a level. Lines are added
+// through the component.
+UCLASS()
+class LINERENDERER_API ALineBatch : public AActor
+{
+    GENERATED_BODY()
+
+    // METHODS
+
+    public: ALineBatch();
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Batch")
+    ULineBatchComponent* GetBatch() const;
+
+    // PROPERTIES
+
+    public: UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Line Renderer|Batch")
+    ULineBatchComponent* Batch = nullptr;
+};
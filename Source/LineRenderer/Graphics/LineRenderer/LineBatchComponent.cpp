@@ -0,0 +1,261 @@
+﻿// Copyright Hollywood Camera Work
+
+#include "LineBatchComponent.h"
+#include "LineRendererIncludes.h"
+#include "LineMesh.h"
+#include "Materials/Material.h"
+#include "Materials/MaterialInstanceDynamic.h"
+
+ULineBatchComponent::ULineBatchComponent()
+{
+    // Only ticks to apply changes, and switches itself off again after.
+    PrimaryComponentTick.bCanEverTick = true;
+    PrimaryComponentTick.bStartWithTickEnabled = false;
+    bTickInEditor = true;
+
+    SetCanEverAffectNavigation(false);
+    SetCastShadow(false);
+    bAffectDistanceFieldLighting = false;
+    bAffectDynamicIndirectLighting = false;
+
+    Groups.SetNum(ETOINT(ELineRendererStyle::TheEnd));
+    StyleMaterials.SetNum(ETOINT(ELineRendererStyle::TheEnd));
+}
+
+void ULineBatchComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+    Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+    Flush();
+    SetComponentTickEnabled(false);
+}
+
+//
+// LINES
+//
+
+FLineBatchHandle ULineBatchComponent::AddLine(const FLineBatchLine& Line)
+{
+    int32 Index;
+    if (FreeSlots.Num() > 0) {
+        Index = FreeSlots.Pop(false);
+    } else {
+        Index = Slots.AddDefaulted();
+    }
+
+    FLineSlot& Slot = Slots[Index];
+    Slot.Line = Line;
+    Slot.Active = true;
+    ++NumLines;
+    MarkLineDirty(Index);
+
+    FLineBatchHandle Handle;
+    Handle.Index = Index;
+    Handle.Generation = Slot.Generation;
+    return Handle;
+}
+
+bool ULineBatchComponent::UpdateLine(const FLineBatchHandle Handle, const FLineBatchLine& Line)
+{
+    if (!IsValidLine(Handle)) {
+        return false;
+    }
+
+    Slots[Handle.Index].Line = Line;
+    MarkLineDirty(Handle.Index);
+    return true;
+}
+
+bool ULineBatchComponent::RemoveLine(const FLineBatchHandle Handle)
+{
+    if (!IsValidLine(Handle)) {
+        return false;
+    }
+
+    FLineSlot& Slot = Slots[Handle.Index];
+    if (Slot.Group != INDEX_NONE) {
+        Groups[Slot.Group].LayoutDirty = true;
+        SetComponentTickEnabled(true);
+    }
+
+    // Keep the slot's dirty state, it may still be in DirtyLines. Flush() skips inactive slots.
+    const bool Dirty = Slot.Dirty;
+    const int32 Generation = Slot.Generation;
+    Slot = FLineSlot();
+    Slot.Dirty = Dirty;
+    Slot.Generation = Generation + 1;
+
+    FreeSlots.Add(Handle.Index);
+    --NumLines;
+    return true;
+}
+
+bool ULineBatchComponent::IsValidLine(const FLineBatchHandle Handle) const
+{
+    return Slots.IsValidIndex(Handle.Index) && Slots[Handle.Index].Active && Slots[Handle.Index].Generation == Handle.Generation;
+}
+
+int32 ULineBatchComponent::GetNumLines() const
+{
+    return NumLines;
+}
+
+void ULineBatchComponent::MarkLineDirty(const int32 Index)
+{
+    FLineSlot& Slot = Slots[Index];
+    if (!Slot.Dirty) {
+        Slot.Dirty = true;
+        DirtyLines.Add(Index);
+    }
+    SetComponentTickEnabled(true);
+}
+
+//
+// MESH
+//
+
+void ULineBatchComponent::Flush()
+{
+    // Rebuild the changed lines. Lines that stay in their group with the same number of vertices
+    // are copied over their old vertices. Anything else repacks the groups involved.
+
+    for (const int32 Index : DirtyLines) {
+        FLineSlot& Slot = Slots[Index];
+        Slot.Dirty = false;
+        if (!Slot.Active) {
+            continue;
+        }
+
+        BuildLine(Slot);
+
+        const int32 Group = GroupOfStyle(Slot.Line.Style);
+        const bool SameLayout =
+            Slot.Group == Group &&
+            Slot.NumBody == Slot.Geometry.Line.Vertices.Num() &&
+            Slot.NumStartArrow == Slot.Geometry.StartArrowMesh.Vertices.Num() &&
+            Slot.NumEndArrow == Slot.Geometry.EndArrowMesh.Vertices.Num();
+
+        if (SameLayout) {
+            CopyLineVertices(Slot);
+            Groups[Group].VerticesDirty = true;
+        } else {
+            if (Slot.Group != INDEX_NONE) {
+                Groups[Slot.Group].LayoutDirty = true;
+            }
+            Groups[Group].LayoutDirty = true;
+            Slot.Group = Group;
+        }
+    }
+    DirtyLines.Reset();
+
+    // Upload the changed groups.
+
+    for (int32 Group = 0; Group < Groups.Num(); ++Group) {
+        FStyleGroup& StyleGroup = Groups[Group];
+        const FLineMeshSection& Mesh = StyleGroup.Mesh;
+
+        if (StyleGroup.LayoutDirty) {
+            PackGroup(Group);
+            if (Mesh.Vertices.Num() > 0) {
+                CreateMeshSection_LinearColor(Group, Mesh.Vertices, Mesh.Triangles, {}, Mesh.Uvs, {}, {}, false);
+                if (StyleMaterials[Group] == nullptr) {
+                    UMaterial* LoadedMaterial = ULineMesh::LoadStyleMaterial(static_cast<ELineRendererStyle>(Group));
+                    StyleMaterials[Group] = LoadedMaterial != nullptr ? UMaterialInstanceDynamic::Create(LoadedMaterial, this) : nullptr;
+                    UpdateMaterials();
+                }
+                SetMaterial(Group, StyleMaterials[Group]);
+            } else {
+                ClearMeshSection(Group);
+            }
+        } else if (StyleGroup.VerticesDirty) {
+            UpdateMeshSection_LinearColor(Group, Mesh.Vertices, {}, Mesh.Uvs, {}, {}, false);
+        }
+
+        StyleGroup.LayoutDirty = false;
+        StyleGroup.VerticesDirty = false;
+    }
+}
+
+void ULineBatchComponent::BuildLine(FLineSlot& Slot)
+{
+    const FLineBatchLine& Line = Slot.Line;
+
+    Slot.Bezier.Points = Line.Points;
+    Slot.Bezier.HardCorners = Line.HardCorners;
+    Slot.Bezier.TangentStrength = Line.TangentStrength;
+    Slot.Bezier.TessellationQuality = Line.TessellationQuality;
+    Slot.Bezier.Calculate();
+
+    Slot.Geometry.UpVector = Line.UpVector;
+    Slot.Geometry.LineWidth = Line.LineWidth;
+    Slot.Geometry.StartArrow = Line.StartArrow;
+    Slot.Geometry.EndArrow = Line.EndArrow;
+    Slot.Geometry.ArrowScale = Line.ArrowScale;
+    Slot.Geometry.Build(Slot.Bezier);
+}
+
+void ULineBatchComponent::CopyLineVertices(const FLineSlot& Slot)
+{
+    FLineMeshSection& Mesh = Groups[Slot.Group].Mesh;
+    int32 Offset = Slot.VertexOffset;
+
+    for (const FLineMeshSection* Part : { &Slot.Geometry.Line, &Slot.Geometry.StartArrowMesh, &Slot.Geometry.EndArrowMesh }) {
+        FMemory::Memcpy(Mesh.Vertices.GetData() + Offset, Part->Vertices.GetData(), Part->Vertices.Num() * sizeof(FVector));
+        FMemory::Memcpy(Mesh.Uvs.GetData() + Offset, Part->Uvs.GetData(), Part->Uvs.Num() * sizeof(FVector2D));
+        Offset += Part->Vertices.Num();
+    }
+}
+
+void ULineBatchComponent::PackGroup(const int32 Group)
+{
+    // Each line is packed as its body, then its start and end arrowheads, with their triangles
+    // moved to where their vertices ended up.
+
+    FLineMeshSection& Mesh = Groups[Group].Mesh;
+    Mesh.Vertices.Reset();
+    Mesh.Uvs.Reset();
+    Mesh.Triangles.Reset();
+
+    for (FLineSlot& Slot : Slots) {
+        if (!Slot.Active || Slot.Group != Group) {
+            continue;
+        }
+
+        Slot.VertexOffset = Mesh.Vertices.Num();
+        Slot.NumBody = Slot.Geometry.Line.Vertices.Num();
+        Slot.NumStartArrow = Slot.Geometry.StartArrowMesh.Vertices.Num();
+        Slot.NumEndArrow = Slot.Geometry.EndArrowMesh.Vertices.Num();
+
+        for (const FLineMeshSection* Part : { &Slot.Geometry.Line, &Slot.Geometry.StartArrowMesh, &Slot.Geometry.EndArrowMesh }) {
+            const int32 Base = Mesh.Vertices.Num();
+            Mesh.Vertices.Append(Part->Vertices);
+            Mesh.Uvs.Append(Part->Uvs);
+            for (const int32 Index : Part->Triangles) {
+                Mesh.Triangles.Add(Base + Index);
+            }
+        }
+    }
+}
+
+int32 ULineBatchComponent::GroupOfStyle(const ELineRendererStyle Style)
+{
+    return ETOINT(Style == ELineRendererStyle::None ? ELineRendererStyle::SolidColor : Style);
+}
+
+//
+// MATERIALS
+//
+
+void ULineBatchComponent::UpdateMaterials()
+{
+    // Same parameters as ALineRenderer passes to its line mesh.
+
+    for (UMaterialInstanceDynamic* MaterialInstance : StyleMaterials) {
+        if (MaterialInstance == nullptr) {
+            continue;
+        }
+        MaterialInstance->SetVectorParameterValue(FName("Color1"), LineBodyColor);
+        MaterialInstance->SetVectorParameterValue(FName("Color2"), ArrowheadColor);
+        MaterialInstance->SetScalarParameterValue(FName("UvDensity"), UvDensity);
+        MaterialInstance->SetScalarParameterValue(FName("AnimationSpeed"), AnimationSpeed);
+    }
+}
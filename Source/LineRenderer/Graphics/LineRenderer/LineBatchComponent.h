@@ -0,0 +1,158 @@
+﻿// Copyright Hollywood Camera Work
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProceduralMeshComponent.h"
+#include "BezierCalc.h"
+#include "LineMeshBuilder.h"
+#include "LineRendererIncludes.h"
+#include "LineBatchComponent.generated.h"
+
+// STRUCTS
+
+// Identifies a line in a ULineBatchComponent. Goes stale when the line is removed, even if its
+// slot is reused by another line.
+USTRUCT(BlueprintType)
+struct FLineBatchHandle
+{
+    GENERATED_BODY()
+
+    public: UPROPERTY()
+    int32 Index = INDEX_NONE;
+
+    public: UPROPERTY()
+    int32 Generation = 0;
+};
+
+// Everything about a line in a ULineBatchComponent. A subset of ALineRenderer's properties.
+USTRUCT(BlueprintType)
+struct FLineBatchLine
+{
+    GENERATED_BODY()
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    TArray<FVector> Points;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    bool HardCorners = true;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    float TessellationQuality = 0.95;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    float TangentStrength = 0.3;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    float LineWidth = 10;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    bool StartArrow = false;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    bool EndArrow = false;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    float ArrowScale = 1;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    FVector UpVector = FVector(0, 0, 1);
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    ELineRendererStyle Style = ELineRendererStyle::SolidColor;
+};
+
+// Draws many lines from one component, for scenes where an ALineRenderer per line would mean
+// thousands of actors and components. Lines are plain data behind handles. Each is tessellated
+// with its own FBezierCalc and meshed with FLineMeshBuilder, and all lines of the same style are
+// packed into one mesh section, so there is one section per style in use. Arrowheads take the
+// style of their line. Changes are applied together on the next tick, or with Flush(). A line
+// whose vertex count doesn't change is patched in place. Otherwise its style's section is
+// repacked.
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class LINERENDERER_API ULineBatchComponent : public UProceduralMeshComponent
+{
+    GENERATED_BODY()
+
+    // METHODS
+
+    public: ULineBatchComponent();
+    public: virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Batch")
+    FLineBatchHandle AddLine(const FLineBatchLine& Line);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Batch")
+    bool UpdateLine(const FLineBatchHandle Handle, const FLineBatchLine& Line);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Batch")
+    bool RemoveLine(const FLineBatchHandle Handle);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Batch")
+    bool IsValidLine(const FLineBatchHandle Handle) const;
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Batch")
+    int32 GetNumLines() const;
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Batch")
+    void Flush();
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Batch")
+    void UpdateMaterials();
+
+    private: struct FLineSlot;
+    private: void MarkLineDirty(const int32 Index);
+    private: void BuildLine(FLineSlot& Slot);
+    private: void CopyLineVertices(const FLineSlot& Slot);
+    private: void PackGroup(const int32 Group);
+    private: static int32 GroupOfStyle(const ELineRendererStyle Style);
+
+    // PROPERTIES
+
+    // Material parameters, shared by all lines. Call UpdateMaterials() after changing them.
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Batch")
+    FLinearColor LineBodyColor = FLinearColor(0, 0.03, 0.6, 1);
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Batch")
+    FLinearColor ArrowheadColor = FLinearColor(0, 0.24, 0.54, 1);
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Batch")
+    float UvDensity = 1;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Batch")
+    float AnimationSpeed = 1;
+
+    // PRIVATE PROPERTIES
+
+    private: struct FLineSlot
+    {
+        FLineBatchLine Line;
+        FBezierCalc Bezier;
+        FLineMeshBuilder Geometry;
+        int32 Generation = 0;
+        bool Active = false;
+        bool Dirty = false; // In DirtyLines.
+        int32 Group = INDEX_NONE; // Section the line is packed into, INDEX_NONE if not packed yet.
+        int32 VertexOffset = 0; // In the group's vertices.
+        int32 NumBody = 0; // Vertex counts as packed.
+        int32 NumStartArrow = 0;
+        int32 NumEndArrow = 0;
+    };
+
+    // All lines of one style, packed into one section. The section index is the style.
+    private: struct FStyleGroup
+    {
+        FLineMeshSection Mesh;
+        bool LayoutDirty = false; // Lines were added, removed or changed size. Needs repacking.
+        bool VerticesDirty = false; // Only vertices changed.
+    };
+
+    private: TArray<FLineSlot> Slots;
+    private: TArray<int32> FreeSlots;
+    private: TArray<int32> DirtyLines;
+    private: TArray<FStyleGroup> Groups;
+    private: int32 NumLines = 0;
+
+    private: UPROPERTY()
+    TArray<UMaterialInstanceDynamic*> StyleMaterials;
+};
@@ -0,0 +1,73 @@
+﻿// Copyright Hollywood Camera Work
+
+#include "LineBvh.h"
+
+#include "LineHitQueryContext.h"
+
+void FLineBvh::Build(TConstArrayView<FVector> Points, const bool InFragments)
+{
+    Nodes.Reset();
+    Fragments = InFragments;
+    Built = true;
+
+    const int32 NumItems = Fragments ? Points.Num() - 1 : Points.Num();
+    if (NumItems <= 0) {
+        return;
+    }
+
+    Nodes.Reserve(2 * FMath::DivideAndRoundUp(NumItems, LeafSize));
+    BuildNode(Points, 0, NumItems);
+}
+
+int32 FLineBvh::BuildNode(TConstArrayView<FVector> Points, const int32 First, const int32 Num)
+{
+    // Builds the node for items First to First + Num, and its children. Returns the node index.
+
+    const int32 NodeIndex = Nodes.Add(FNode{FBox(ForceInit), First, Num, INDEX_NONE});
+
+    if (Num <= LeafSize) {
+        // A fragment also reaches the point after it.
+        FBox Bounds(ForceInit);
+        const int32 LastPoint = First + Num - (Fragments ? 0 : 1);
+        for (int32 i = First; i <= LastPoint; ++i) {
+            Bounds += Points[i];
+        }
+        Nodes[NodeIndex].Bounds = Bounds;
+        return NodeIndex;
+    }
+
+    // Nodes may reallocate while building children, so don't hold on to references.
+    const int32 Half = Num / 2;
+    const int32 FirstChild = BuildNode(Points, First, Half);
+    const int32 SecondChild = BuildNode(Points, First + Half, Num - Half);
+
+    Nodes[NodeIndex].Bounds = Nodes[FirstChild].Bounds + Nodes[SecondChild].Bounds;
+    Nodes[NodeIndex].SecondChild = SecondChild;
+    return NodeIndex;
+}
+
+void FLineBvh::Invalidate()
+{
+    Built = false;
+}
+
+bool FLineBvh::IsBuilt() const
+{
+    return Built;
+}
+
+float FLineBvh::ScreenDistance(const FLineHitQueryContext& Context, const FBox& Bounds, const FVector2D& HitPos)
+{
+    // Screen distance from HitPos to the rectangle around the projected box, which is never
+    // further away than anything inside the box. If any corner is behind the camera the projection
+    // can't be trusted, so the box can't be culled.
+
+    FBox2D ScreenBounds(ForceInit);
+    if (!Context.ProjectBounds(Bounds, ScreenBounds)) {
+        return 0;
+    }
+
+    const double DistanceX = FMath::Max3(ScreenBounds.Min.X - HitPos.X, 0.0, HitPos.X - ScreenBounds.Max.X);
+    const double DistanceY = FMath::Max3(ScreenBounds.Min.Y - HitPos.Y, 0.0, HitPos.Y - ScreenBounds.Max.Y);
+    return FMath::Sqrt(DistanceX * DistanceX + DistanceY * DistanceY);
+}
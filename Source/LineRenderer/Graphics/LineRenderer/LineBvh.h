@@ -0,0 +1,87 @@
+﻿// Copyright Hollywood Camera Work
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FLineHitQueryContext;
+
+// Bounding volume hierarchy over a polyline, for screen space hit detection. Items are either the
+// points themselves, or the fragments between consecutive points. A line is already spatially
+// coherent, so each node simply splits its range of items in half. Nodes are stored depth first,
+// so the first child of a node always follows it directly.
+class LINERENDERER_API FLineBvh
+{
+    // METHODS
+
+    public: void Build(TConstArrayView<FVector> Points, const bool InFragments);
+    private: int32 BuildNode(TConstArrayView<FVector> Points, const int32 First, const int32 Num);
+    public: void Invalidate();
+    public: bool IsBuilt() const;
+    public: template <typename FLeafFunc> void Query(const FLineHitQueryContext& Context, const FVector2D& HitPos, const float& BestDistance, FLeafFunc&& Leaf) const;
+    private: static float ScreenDistance(const FLineHitQueryContext& Context, const FBox& Bounds, const FVector2D& HitPos);
+
+    // PROPERTIES
+
+    public: static constexpr int32 LeafSize = 8;
+
+    // PRIVATE PROPERTIES
+
+    private: struct FNode
+    {
+        FBox Bounds;
+        int32 First = 0; // First item in this node.
+        int32 Num = 0; // Number of items in this node.
+        int32 SecondChild = INDEX_NONE; // INDEX_NONE for leaves.
+    };
+
+    private: TArray<FNode> Nodes;
+    private: bool Fragments = false;
+    private: bool Built = false;
+};
+
+template <typename FLeafFunc>
+void FLineBvh::Query(const FLineHitQueryContext& Context, const FVector2D& HitPos, const float& BestDistance, FLeafFunc&& Leaf) const
+{
+    // Calls Leaf(First, Num) for every leaf that could hold an item closer to HitPos than
+    // BestDistance, nearest first. Leaf is expected to lower BestDistance as it finds closer items,
+    // which prunes whatever is left of the search.
+
+    if (Nodes.Num() == 0) {
+        return;
+    }
+
+    struct FEntry
+    {
+        int32 Node;
+        float Distance;
+    };
+
+    TArray<FEntry, TInlineAllocator<64>> Stack;
+    Stack.Add(FEntry{0, ScreenDistance(Context, Nodes[0].Bounds, HitPos)});
+
+    while (Stack.Num() > 0) {
+        const FEntry Entry = Stack.Pop(false);
+        if (Entry.Distance >= BestDistance) {
+            continue;
+        }
+
+        const FNode& Node = Nodes[Entry.Node];
+        if (Node.SecondChild == INDEX_NONE) {
+            Leaf(Node.First, Node.Num);
+            continue;
+        }
+
+        // Push the nearer child last, so it's searched first.
+        const FEntry FirstChild{Entry.Node + 1, ScreenDistance(Context, Nodes[Entry.Node + 1].Bounds, HitPos)};
+        const FEntry SecondChild{Node.SecondChild, ScreenDistance(Context, Nodes[Node.SecondChild].Bounds, HitPos)};
+
+        if (FirstChild.Distance <= SecondChild.Distance) {
+            Stack.Add(SecondChild);
+            Stack.Add(FirstChild);
+        } else {
+            Stack.Add(FirstChild);
+            Stack.Add(SecondChild);
+        }
+    }
+}
@@ -0,0 +1,125 @@
+﻿// Copyright Hollywood Camera Work
+
+#include "LineControlPoints.h"
+#include "LineRendererIncludes.h"
+
+void ULineControlPoints::Init()
+{
+    // The sphere is loaded once and shared by all lines.
+    static TWeakObjectPtr<UStaticMesh> SharedSphereMesh;
+    if (!SharedSphereMesh.IsValid()) {
+        SharedSphereMesh = Cast<UStaticMesh>(StaticLoadObject(UStaticMesh::StaticClass(), nullptr, TEXT("StaticMesh'/Engine/BasicShapes/Sphere.Sphere'")));
+    }
+    
+    SphereMesh = SharedSphereMesh.Get();
+    if (SphereMesh) {
+        SetStaticMesh(SphereMesh);
+        SetNumCustomDataFloats(4);
+        SetCanEverAffectNavigation(false);
+        bCastCinematicShadow = false;
+        bCastContactShadow = false;
+        bCastDynamicShadow = false;
+        bCastFarShadow = false;
+        bCastHiddenShadow = false;
+        bCastInsetShadow = false;
+        bCastStaticShadow = false;
+        bCastVolumetricTranslucentShadow = false;
+        bCastDistanceFieldIndirectShadow = false;
+        bAffectDistanceFieldLighting = false;
+        bAffectDynamicIndirectLighting = false;
+        SetCastShadow(false);
+        SetCastContactShadow(false);
+        SetCastHiddenShadow(false);
+        SetCastInsetShadow(false);
+    }
+}
+
+void ULineControlPoints::SetQuantity(const int32 Desired)
+{
+    const int32 Current = GetInstanceCount();
+    if (Desired == Current) {
+        return;
+    }
+
+    if (Desired == 0) {
+        ClearInstances();
+        return;
+    }
+
+    // New instances are placed by the next UpdatePositions().
+
+    if (Desired > Current) {
+        Transforms.Reset();
+        Transforms.Init(FTransform::Identity, Desired - Current);
+        AddInstances(Transforms, false, true);
+        SetColorData(Current);
+    } else {
+        for (int32 i = Current - 1; i >= Desired; --i) {
+            RemoveInstance(i);
+        }
+    }
+}
+
+void ULineControlPoints::UpdatePositions(const TArray<FVector>& Points)
+{
+    // This is a scale of the static mesh, which is already 100 wide, multiplied by 1.5 because
+    // control points by default are 1.5 times the line width.
+    const float Scale = (LineWidth * ControlPointScale * 1.5) / 100;
+    
+    const int32 Num = FMath::Min(Points.Num(), GetInstanceCount());
+    if (Num == 0) {
+        return;
+    }
+    
+    Transforms.SetNum(Num, false);
+    for (int32 i = 0; i < Num; ++i) {
+        Transforms[i] = FTransform(FQuat::Identity, Points[i], FVector(Scale, Scale, Scale));
+    }
+    BatchUpdateInstancesTransforms(0, Transforms, true, true, false);
+}
+
+void ULineControlPoints::UpdateMaterial()
+{
+    // The material is shared through the world's cache with all control points and lines of the
+    // same color.
+    
+    FLineMaterialKey Key;
+    Key.Style = ELineRendererStyle::SolidColor;
+    Key.Color1 = ControlPointColor;
+
+    if (!(Key == MaterialKey)) {
+        if (ULineMaterialCache* Cache = ULineMaterialCache::Get(this)) {
+            MaterialInstance = Cache->Exchange(MaterialKey, Key);
+            SetMaterial(0, MaterialInstance);
+        }
+    }
+
+    if (!MaterialInstance) {
+        UE_LOG(LogTemp, Log, TEXT("No material instance on control points"));
+    }
+
+    SetColorData(0);
+}
+
+void ULineControlPoints::OnComponentDestroyed(const bool bDestroyingHierarchy)
+{
+    if (ULineMaterialCache* Cache = ULineMaterialCache::Get(this)) {
+        Cache->Release(MaterialKey);
+    }
+    MaterialKey = FLineMaterialKey();
+    MaterialInstance = nullptr;
+    Super::OnComponentDestroyed(bDestroyingHierarchy);
+}
+
+void ULineControlPoints::SetColorData(const int32 FirstInstance)
+{
+    const int32 Num = GetInstanceCount();
+    if (FirstInstance >= Num) {
+        return;
+    }
+    
+    const TArray<float> Color = { ControlPointColor.R, ControlPointColor.G, ControlPointColor.B, ControlPointColor.A };
+    for (int32 i = FirstInstance; i < Num; ++i) {
+        SetCustomData(i, Color, i == Num - 1);
+    }
+}
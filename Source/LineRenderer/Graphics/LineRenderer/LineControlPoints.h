@@ -0,0 +1,42 @@
+﻿// Copyright Hollywood Camera Work
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "LineMaterialCache.h"
+#include "LineControlPoints.generated.h"
+
+class UStaticMesh;
+
+// All control points of a line, drawn as instances of one sphere mesh, so a line with hundreds of
+// points is still one component and one draw call. The color is also written to the first four
+// per-instance custom data floats, for materials that read it from there.
+UCLASS()
+class LINERENDERER_API ULineControlPoints : public UInstancedStaticMeshComponent
+{
+    GENERATED_BODY()
+
+    public: void Init();
+    public: void SetQuantity(const int32 Desired);
+    public: void UpdatePositions(const TArray<FVector>& Points);
+    public: void UpdateMaterial();
+    public: virtual void OnComponentDestroyed(bool bDestroyingHierarchy) override;
+    private: void SetColorData(const int32 FirstInstance);
+    
+    // PROPERTIES
+
+    public: float LineWidth = 10;
+    public: float ControlPointScale = 2;
+    public: FLinearColor ControlPointColor = FLinearColor(1, 1, 1, 1);
+    
+    private: UPROPERTY()
+    UStaticMesh* SphereMesh = nullptr;
+
+    private: UPROPERTY()
+    UMaterialInstanceDynamic* MaterialInstance = nullptr;
+
+    private: FLineMaterialKey MaterialKey; // Held in ULineMaterialCache.
+
+    private: TArray<FTransform> Transforms; // Scratch for UpdatePositions().
+};
@@ -0,0 +1,158 @@
+﻿// Copyright Hollywood Camera Work
+
+#include "LineHitQueryContext.h"
+#include "LineScratchStats.h"
+
+#include "Engine/GameViewportClient.h"
+#include "Engine/LocalPlayer.h"
+#include "GameFramework/PlayerController.h"
+#include "SceneView.h"
+
+bool FLineHitQueryContext::Init(const APlayerController* Player)
+{
+    // Same view data that ProjectWorldLocationToScreen() fetches on every call.
+
+    Valid = false;
+
+    const ULocalPlayer* LocalPlayer = Player ? Player->GetLocalPlayer() : nullptr;
+    if (LocalPlayer == nullptr || LocalPlayer->ViewportClient == nullptr) {
+        return false;
+    }
+
+    FSceneViewProjectionData ProjectionData;
+    if (!LocalPlayer->GetProjectionData(LocalPlayer->ViewportClient->Viewport, ProjectionData)) {
+        return false;
+    }
+
+    Init(ProjectionData.ComputeViewProjectionMatrix(), ProjectionData.GetConstrainedViewRect());
+    return true;
+}
+
+void FLineHitQueryContext::Init(const FMatrix& InViewProjectionMatrix, const FIntRect& InViewRect)
+{
+    ViewProjectionMatrix = InViewProjectionMatrix;
+    InverseViewProjectionMatrix = InViewProjectionMatrix.Inverse();
+    ViewRect = InViewRect;
+    Valid = true;
+}
+
+bool FLineHitQueryContext::IsValid() const
+{
+    return Valid;
+}
+
+bool FLineHitQueryContext::Project(const FVector& WorldPoint, FVector2D& OutScreenPoint) const
+{
+    bool OnScreenResult = false;
+    ProjectPoints(MakeArrayView(&WorldPoint, 1), &OutScreenPoint, &OnScreenResult);
+    return OnScreenResult;
+}
+
+void FLineHitQueryContext::ProjectPoints(TConstArrayView<FVector> WorldPoints, FVector2D* OutScreenPoints, bool* OutOnScreen) const
+{
+    // Same math as FSceneView::ProjectWorldToScreen(), four points at a time. The view rect
+    // scaling is folded into the perspective divide, so each axis is one multiply-add after it.
+    // Points behind the camera still get a (mirrored) position, but are flagged as not on screen.
+
+    const FMatrix& M = ViewProjectionMatrix;
+    const double HalfWidth = ViewRect.Width() * 0.5;
+    const double HalfHeight = ViewRect.Height() * 0.5;
+    const double CenterX = ViewRect.Min.X + HalfWidth;
+    const double CenterY = ViewRect.Min.Y + HalfHeight;
+
+    constexpr int32 Lanes = 4;
+    int32 i = 0;
+
+    if (WorldPoints.Num() >= Lanes) {
+        const VectorRegister4Double M00 = VectorSetFloat1(M.M[0][0]), M10 = VectorSetFloat1(M.M[1][0]), M20 = VectorSetFloat1(M.M[2][0]), M30 = VectorSetFloat1(M.M[3][0]);
+        const VectorRegister4Double M01 = VectorSetFloat1(M.M[0][1]), M11 = VectorSetFloat1(M.M[1][1]), M21 = VectorSetFloat1(M.M[2][1]), M31 = VectorSetFloat1(M.M[3][1]);
+        const VectorRegister4Double M03 = VectorSetFloat1(M.M[0][3]), M13 = VectorSetFloat1(M.M[1][3]), M23 = VectorSetFloat1(M.M[2][3]), M33 = VectorSetFloat1(M.M[3][3]);
+        const VectorRegister4Double ScaleX = VectorSetFloat1(HalfWidth), ScaleY = VectorSetFloat1(-HalfHeight);
+        const VectorRegister4Double OffsetX = VectorSetFloat1(CenterX), OffsetY = VectorSetFloat1(CenterY);
+        const VectorRegister4Double One = VectorSetFloat1(1.0);
+
+        double ScreenX[Lanes];
+        double ScreenY[Lanes];
+        double W[Lanes];
+
+        for (; i + Lanes <= WorldPoints.Num(); i += Lanes) {
+            const FVector* P = WorldPoints.GetData() + i;
+            const VectorRegister4Double X = MakeVectorRegisterDouble(P[0].X, P[1].X, P[2].X, P[3].X);
+            const VectorRegister4Double Y = MakeVectorRegisterDouble(P[0].Y, P[1].Y, P[2].Y, P[3].Y);
+            const VectorRegister4Double Z = MakeVectorRegisterDouble(P[0].Z, P[1].Z, P[2].Z, P[3].Z);
+
+            const VectorRegister4Double ClipX = VectorMultiplyAdd(X, M00, VectorMultiplyAdd(Y, M10, VectorMultiplyAdd(Z, M20, M30)));
+            const VectorRegister4Double ClipY = VectorMultiplyAdd(X, M01, VectorMultiplyAdd(Y, M11, VectorMultiplyAdd(Z, M21, M31)));
+            const VectorRegister4Double ClipW = VectorMultiplyAdd(X, M03, VectorMultiplyAdd(Y, M13, VectorMultiplyAdd(Z, M23, M33)));
+
+            const VectorRegister4Double Rhw = VectorDivide(One, ClipW);
+            VectorStore(VectorMultiplyAdd(VectorMultiply(ClipX, Rhw), ScaleX, OffsetX), ScreenX);
+            VectorStore(VectorMultiplyAdd(VectorMultiply(ClipY, Rhw), ScaleY, OffsetY), ScreenY);
+            VectorStore(ClipW, W);
+
+            for (int32 Lane = 0; Lane < Lanes; ++Lane) {
+                OutScreenPoints[i + Lane] = FVector2D(ScreenX[Lane], ScreenY[Lane]);
+                OutOnScreen[i + Lane] = W[Lane] > 0;
+            }
+        }
+    }
+
+    // Remainder that doesn't fill a whole register.
+    for (; i < WorldPoints.Num(); ++i) {
+        const FVector4 Clip = M.TransformFVector4(FVector4(WorldPoints[i], 1));
+        const double Rhw = 1.0 / Clip.W;
+        OutScreenPoints[i] = FVector2D(Clip.X * Rhw * HalfWidth + CenterX, -Clip.Y * Rhw * HalfHeight + CenterY);
+        OutOnScreen[i] = Clip.W > 0;
+    }
+}
+
+void FLineHitQueryContext::ProjectToScratch(TConstArrayView<FVector> WorldPoints)
+{
+    // Projects into ScreenPoints and OnScreen, which keep their allocations between calls.
+
+    FLineScratchStats::Reserve(ScreenPoints, WorldPoints.Num());
+    FLineScratchStats::Reserve(OnScreen, WorldPoints.Num());
+    ScreenPoints.SetNumUninitialized(WorldPoints.Num(), false);
+    OnScreen.SetNumUninitialized(WorldPoints.Num(), false);
+    ProjectPoints(WorldPoints, ScreenPoints.GetData(), OnScreen.GetData());
+}
+
+bool FLineHitQueryContext::ProjectBounds(const FBox& Bounds, FBox2D& OutScreenBounds) const
+{
+    // Screen rectangle around the projected corners of the box, which contains everything inside
+    // the box. Returns false if any corner is behind the camera, because the rectangle can't be
+    // trusted then.
+
+    FVector Corners[8];
+    FVector2D Projected[8];
+    bool CornerOnScreen[8];
+
+    for (int32 Corner = 0; Corner < 8; ++Corner) {
+        Corners[Corner] = FVector(
+            (Corner & 1) ? Bounds.Max.X : Bounds.Min.X,
+            (Corner & 2) ? Bounds.Max.Y : Bounds.Min.Y,
+            (Corner & 4) ? Bounds.Max.Z : Bounds.Min.Z
+        );
+    }
+
+    ProjectPoints(Corners, Projected, CornerOnScreen);
+
+    OutScreenBounds = FBox2D(ForceInit);
+    for (int32 Corner = 0; Corner < 8; ++Corner) {
+        if (!CornerOnScreen[Corner]) {
+            return false;
+        }
+        OutScreenBounds += Projected[Corner];
+    }
+    return true;
+}
+
+bool FLineHitQueryContext::Deproject(const FVector2D& ScreenPoint, FVector& OutOrigin, FVector& OutDirection) const
+{
+    if (!Valid) {
+        return false;
+    }
+
+    FSceneView::DeprojectScreenToWorld(ScreenPoint, ViewRect, InverseViewProjectionMatrix, OutOrigin, OutDirection);
+    return true;
+}
@@ -0,0 +1,40 @@
+﻿// Copyright Hollywood Camera Work
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class APlayerController;
+
+// The view of one player, captured once so that any number of hit detection queries can project
+// points to screen without going back to the player. Build it once per frame (or per query across
+// all lines) with Init(). Also holds scratch memory for projected points that is reused between
+// queries. Screen positions are the same as APlayerController::ProjectWorldLocationToScreen() with
+// bPlayerViewportRelative false.
+class LINERENDERER_API FLineHitQueryContext
+{
+    // METHODS
+
+    public: bool Init(const APlayerController* Player);
+    public: void Init(const FMatrix& InViewProjectionMatrix, const FIntRect& InViewRect);
+    public: bool IsValid() const;
+    public: bool Project(const FVector& WorldPoint, FVector2D& OutScreenPoint) const;
+    public: void ProjectPoints(TConstArrayView<FVector> WorldPoints, FVector2D* OutScreenPoints, bool* OutOnScreen) const;
+    public: void ProjectToScratch(TConstArrayView<FVector> WorldPoints);
+    public: bool ProjectBounds(const FBox& Bounds, FBox2D& OutScreenBounds) const;
+    public: bool Deproject(const FVector2D& ScreenPoint, FVector& OutOrigin, FVector& OutDirection) const;
+
+    // PROPERTIES
+
+    public: FMatrix ViewProjectionMatrix = FMatrix::Identity;
+    public: FMatrix InverseViewProjectionMatrix = FMatrix::Identity;
+    public: FIntRect ViewRect;
+
+    // Output of ProjectToScratch(). OnScreen is false for points behind the camera.
+    public: TArray<FVector2D> ScreenPoints;
+    public: TArray<bool> OnScreen;
+
+    // PRIVATE PROPERTIES
+
+    private: bool Valid = false;
+};
@@ -0,0 +1,120 @@
+﻿// Copyright Hollywood Camera Work
+
+#include "LineMaterialCache.h"
+#include "LineMesh.h"
+
+#include "Engine/World.h"
+#include "Materials/Material.h"
+#include "Materials/MaterialInstanceDynamic.h"
+
+bool FLineMaterialKey::operator==(const FLineMaterialKey& Other) const
+{
+    return
+        Style == Other.Style &&
+        Color1 == Other.Color1 &&
+        Color2 == Other.Color2 &&
+        UvDensity == Other.UvDensity &&
+        AnimationSpeed == Other.AnimationSpeed;
+}
+
+uint32 GetTypeHash(const FLineMaterialKey& Key)
+{
+    uint32 Hash = GetTypeHash(Key.Style);
+    Hash = HashCombine(Hash, GetTypeHash(Key.Color1));
+    Hash = HashCombine(Hash, GetTypeHash(Key.Color2));
+    Hash = HashCombine(Hash, GetTypeHash(Key.UvDensity));
+    return HashCombine(Hash, GetTypeHash(Key.AnimationSpeed));
+}
+
+ULineMaterialCache* ULineMaterialCache::Get(const UObject* WorldContext)
+{
+    const UWorld* World = WorldContext != nullptr ? WorldContext->GetWorld() : nullptr;
+    return World != nullptr ? World->GetSubsystem<ULineMaterialCache>() : nullptr;
+}
+
+void ULineMaterialCache::Deinitialize()
+{
+    Entries.Empty();
+    Materials.Empty();
+    BaseMaterials.Empty();
+    BaseMaterialLoaded.Empty();
+    Super::Deinitialize();
+}
+
+bool ULineMaterialCache::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    // Also lines shown in editor previews, such as the blueprint editor viewport.
+    return Super::DoesSupportWorldType(WorldType) || WorldType == EWorldType::EditorPreview || WorldType == EWorldType::GamePreview;
+}
+
+UMaterial* ULineMaterialCache::GetBaseMaterial(const ELineRendererStyle Style)
+{
+    const int32 Index = static_cast<int32>(Style);
+    if (Index >= BaseMaterials.Num()) {
+        BaseMaterials.SetNumZeroed(Index + 1);
+        BaseMaterialLoaded.SetNumZeroed(Index + 1);
+    }
+
+    if (!BaseMaterialLoaded[Index]) {
+        BaseMaterialLoaded[Index] = true;
+        BaseMaterials[Index] = ULineMesh::LoadStyleMaterial(Style);
+    }
+    return BaseMaterials[Index];
+}
+
+UMaterialInstanceDynamic* ULineMaterialCache::Acquire(const FLineMaterialKey& Key)
+{
+    if (FEntry* Entry = Entries.Find(Key)) {
+        ++Entry->References;
+        return Entry->Material;
+    }
+
+    UMaterial* BaseMaterial = GetBaseMaterial(Key.Style);
+    if (BaseMaterial == nullptr) {
+        return nullptr;
+    }
+
+    UMaterialInstanceDynamic* Material = UMaterialInstanceDynamic::Create(BaseMaterial, this);
+    Material->SetVectorParameterValue(FName("Color1"), Key.Color1);
+    Material->SetVectorParameterValue(FName("Color2"), Key.Color2);
+    Material->SetScalarParameterValue(FName("UvDensity"), Key.UvDensity);
+    Material->SetScalarParameterValue(FName("AnimationSpeed"), Key.AnimationSpeed);
+
+    FEntry& Entry = Entries.Add(Key);
+    Entry.Material = Material;
+    Entry.References = 1;
+    Materials.Add(Material);
+    return Material;
+}
+
+void ULineMaterialCache::Release(const FLineMaterialKey& Key)
+{
+    // Keys that were never acquired, or whose material failed to load, are ignored, so holders
+    // can release whatever key they last asked for.
+    
+    FEntry* Entry = Entries.Find(Key);
+    if (Entry == nullptr) {
+        return;
+    }
+
+    if (--Entry->References == 0) {
+        Materials.RemoveSwap(Entry->Material);
+        Entries.Remove(Key);
+    }
+}
+
+UMaterialInstanceDynamic* ULineMaterialCache::Exchange(FLineMaterialKey& InOutHeldKey, const FLineMaterialKey& Key)
+{
+    // Acquires before releasing, so an instance only held by the caller survives a change back to
+    // the same key.
+    
+    UMaterialInstanceDynamic* Material = Acquire(Key);
+    Release(InOutHeldKey);
+    InOutHeldKey = Key;
+    return Material;
+}
+
+int32 ULineMaterialCache::GetNumMaterials() const
+{
+    return Entries.Num();
+}
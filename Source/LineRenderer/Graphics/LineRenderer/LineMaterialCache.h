@@ -0,0 +1,69 @@
+﻿// Copyright Hollywood Camera Work
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "LineRendererIncludes.h"
+#include "LineMaterialCache.generated.h"
+
+class UMaterial;
+class UMaterialInstanceDynamic;
+
+// STRUCTS
+
+// Style and parameters of a line material. Lines with equal keys share a material instance.
+struct FLineMaterialKey
+{
+    ELineRendererStyle Style = ELineRendererStyle::None;
+    FLinearColor Color1 = FLinearColor(0, 0, 0);
+    FLinearColor Color2 = FLinearColor(0, 0, 0);
+    float UvDensity = 1;
+    float AnimationSpeed = 1;
+
+    bool operator==(const FLineMaterialKey& Other) const;
+    friend uint32 GetTypeHash(const FLineMaterialKey& Key);
+};
+
+// Material instances shared by all lines in a world. Each style's base material is loaded once,
+// and lines with the same style and parameters get the same material instance, which lets the
+// renderer batch them. Instances are reference counted, and destroyed with the last line using
+// them. Since they're shared, holders must not change their parameters, but acquire an instance
+// for the new key instead.
+UCLASS()
+class LINERENDERER_API ULineMaterialCache : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+    // METHODS
+
+    public: static ULineMaterialCache* Get(const UObject* WorldContext);
+    public: virtual void Deinitialize() override;
+    public: UMaterial* GetBaseMaterial(const ELineRendererStyle Style);
+    public: UMaterialInstanceDynamic* Acquire(const FLineMaterialKey& Key);
+    public: void Release(const FLineMaterialKey& Key);
+    public: UMaterialInstanceDynamic* Exchange(FLineMaterialKey& InOutHeldKey, const FLineMaterialKey& Key);
+    public: int32 GetNumMaterials() const;
+    protected: virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+    // PRIVATE PROPERTIES
+
+    private: struct FEntry
+    {
+        UMaterialInstanceDynamic* Material = nullptr;
+        int32 References = 0;
+    };
+
+    private: TMap<FLineMaterialKey, FEntry> Entries;
+
+    // Keeps the entries' instances alive.
+    private: UPROPERTY()
+    TArray<UMaterialInstanceDynamic*> Materials;
+
+    // By style. Failed loads aren't retried.
+    private: UPROPERTY()
+    TArray<UMaterial*> BaseMaterials;
+    
+    private: TArray<bool> BaseMaterialLoaded;
+};
@@ -1,79 +1,89 @@
-﻿// Copyright Hollywood Camera Work
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "ProceduralMeshComponent.h"
-#include "LineRendererIncludes.h"
-#include "LineMesh.generated.h"
-
-class FBezierCalc;
-
-UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
-class LINERENDERER_API ULineMesh : public UProceduralMeshComponent
-{
-    GENERATED_BODY()
-    
-    private: struct FMeshParams
-    {
-        TArray<FVector> Vertices;
-        TArray<int32> Triangles;
-        TArray<FVector2D> Uvs;
-    };
-
-    // PUBLIC METHODS
-
-    public: void AutoInit();
-    public: void CreateMesh();
-    public: void UpdatePosition();
-    public: void UpdateMaterial();
-
-    // PRIVATE METHODS
-    
-    private: void CalculateVertexPositions();
-
-    private: static void AddArrowHeadTriangles(FMeshParams& ArrowMesh, const bool Active);
-    private: void CalculateAllArrowHeadVertices();
-    private: void CalculateArrowHeadVertices(FMeshParams& ArrowMesh, const int32 N0, const int32 N1, const int32 N2, const int32 N3);
-
-    public: void DrawDebugLines(const TArray<FVector>& WorldPoints) const;
-    public: void DrawDebugTessellated() const;
-
-    // PUBLIC PROPERTIES
-
-    public: TSharedPtr<FBezierCalc> Bezier;
-    public: FLinearColor Color1 = FLinearColor(0, 0, 0);
-    public: FLinearColor Color2 = FLinearColor(0, 0, 0);
-    public: float UvDensity = 1;
-    public: float AnimationSpeed = 1;
-    public: FVector UpVector = FVector(0, 0, 1);
-    public: float LineWidth = 10;
-    public: ELineRendererStyle LineStyle = ELineRendererStyle::SolidColor;
-    public: ELineRendererStyle ArrowHeadStyle = ELineRendererStyle::SolidColor;
-    public: bool StartArrow = false;
-    public: bool EndArrow = false;
-    public: float ArrowScale = 1;
-    public: int32 DataCycle = 0;
-
-    // PRIVATE PROPERTIES
-
-    private: int32 LastVertexPositionCalculation = 0;
-    
-    private: TArray<FVector> LineVertices;
-    private: TArray<int32> LineTriangles;
-    private: TArray<FVector2D> LineUvs;
-    
-    FMeshParams StartArrowMesh;
-    FMeshParams EndArrowMesh;
-    
-    private: ELineRendererStyle OldLineStyle = ELineRendererStyle::None;
-    private: ELineRendererStyle OldArrowHeadStyle = ELineRendererStyle::None;
-
-    private: UPROPERTY()
-    UMaterialInstanceDynamic* LineMaterialInstance = nullptr;
-
-    private: UPROPERTY()
-    UMaterialInstanceDynamic* ArrowHeadMaterialInstance = nullptr;
-
-    private: TArray<ELineRendererStyle> ElementStyles;
-};
+﻿// Copyright Hollywood Camera Work
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProceduralMeshComponent.h"
+#include "LineRendererIncludes.h"
+#include "LineMeshBuilder.h"
+#include "LineMaterialCache.h"
+#include "LineMesh.generated.h"
+
+class FBezierCalc;
+class UMaterial;
+struct FTessellationSplice;
+
+// Mesh of a line and its arrowheads. The line body is split into chunks of PointsPerChunk
+// tessellated segments, each in its own mesh section with its own bounds, so that edits only send
+// the chunks they touch. Chunk 0 is section 0, the arrowheads are sections 1 and 2, and further
+// chunks follow from section 3. Chunks cover fixed places in the builder's line, so trimming the
+// front of the line only changes the first chunks.
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class LINERENDERER_API ULineMesh : public UProceduralMeshComponent
+{
+    GENERATED_BODY()
+
+    // PUBLIC METHODS
+
+    public: void AutoInit();
+    public: void CreateMesh();
+    public: void UpdateMeshRange(const FTessellationSplice& Splice);
+    public: void CommitMesh(TSharedPtr<FBezierCalc>& InOutBezier, FLineMeshBuilder& InOutGeometry);
+    public: void UpdatePosition();
+    public: void UpdateMaterial();
+    public: virtual void OnComponentDestroyed(bool bDestroyingHierarchy) override;
+    public: static UMaterial* LoadStyleMaterial(const ELineRendererStyle Style);
+
+    // PRIVATE METHODS
+    
+    private: void ApplySettings();
+    private: void UploadMesh();
+    private: void ReleaseMaterials();
+    private: void UploadChunks(const int32 FirstPoint, const int32 LastPoint = MAX_int32);
+    private: static int32 ChunkOfPoint(const int32 Point);
+    private: static int32 ChunkSection(const int32 Chunk);
+    private: void CalculateVertexPositions();
+
+    public: void DrawDebugLines(const TArray<FVector>& WorldPoints) const;
+    public: void DrawDebugTessellated() const;
+
+    // PUBLIC PROPERTIES
+
+    public: TSharedPtr<FBezierCalc> Bezier;
+    public: FLinearColor Color1 = FLinearColor(0, 0, 0);
+    public: FLinearColor Color2 = FLinearColor(0, 0, 0);
+    public: float UvDensity = 1;
+    public: float AnimationSpeed = 1;
+    public: bool ParametersInPrimitiveData = false;
+    public: FVector UpVector = FVector(0, 0, 1);
+    public: float LineWidth = 10;
+    public: ELineRendererStyle LineStyle = ELineRendererStyle::SolidColor;
+    public: ELineRendererStyle ArrowHeadStyle = ELineRendererStyle::SolidColor;
+    public: bool StartArrow = false;
+    public: bool EndArrow = false;
+    public: float ArrowScale = 1;
+    public: int32 DataCycle = 0;
+    public: static constexpr int32 PointsPerChunk = 2048;
+
+    // PRIVATE PROPERTIES
+
+    private: int32 LastVertexPositionCalculation = 0;
+    private: int32 LastMeshUpload = 0;
+    
+    private: FLineMeshBuilder Geometry;
+    private: int32 FirstChunk = 0; // Body sections currently created, from FirstChunk up to NumChunks.
+    private: int32 NumChunks = 0;
+    private: FLineMeshSection ChunkScratch;
+    
+    // Keys of the materials held in ULineMaterialCache.
+    private: FLineMaterialKey LineMaterialKey;
+    private: FLineMaterialKey ArrowHeadMaterialKey;
+
+    private: UPROPERTY()
+    UMaterialInstanceDynamic* LineMaterialInstance = nullptr;
+
+    private: UPROPERTY()
+    UMaterialInstanceDynamic* ArrowHeadMaterialInstance = nullptr;
+
+    private: TArray<ELineRendererStyle> ElementStyles;
+};
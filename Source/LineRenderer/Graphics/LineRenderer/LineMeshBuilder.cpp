@@ -0,0 +1,360 @@
+﻿// Copyright Hollywood Camera Work
+
+#include "LineMeshBuilder.h"
+#include "BezierCalc.h"
+#include "LineScratchStats.h"
+
+void FLineMeshSection::Empty()
+{
+    Vertices.Empty();
+    Triangles.Empty();
+    Uvs.Empty();
+}
+
+void FLineMeshBuilder::Build(const FBezierCalc& Bezier)
+{
+    // Initialize mesh arrays to correct sizes for the current mesh, and set up triangles. Every
+    // arrowhead adds 3 vertices and 6 triangle vertex indexes.
+
+    LineStart = 0;
+    const int32 NumPoints = Bezier.Tessellated.Num();
+    if (NumPoints < 2) {
+        Line.Empty();
+        StartArrowMesh.Empty();
+        EndArrowMesh.Empty();
+        return;
+    }
+
+    // Number of vertices and triangles that will be created by the line. We don't create triangles
+    // for the last point.
+    const int32 NumLineVertices = NumPoints * 2;
+    const int32 NumLineTriangles = (NumPoints - 1) * 6;
+
+    // Pre-allocate vertices, UVs and triangles. Allocations from the previous build are kept.
+    FLineScratchStats::Reserve(Line.Vertices, NumLineVertices);
+    FLineScratchStats::Reserve(Line.Uvs, NumLineVertices);
+    FLineScratchStats::Reserve(Line.Triangles, NumLineTriangles);
+    Line.Vertices.SetNum(NumLineVertices, false);
+    Line.Uvs.SetNum(NumLineVertices, false);
+    Line.Triangles.SetNum(NumLineTriangles, false);
+
+    CalculateLineTriangles(0);
+    CalculateVertexPositions(Bezier);
+
+    // Add arrowheads. Start at the end of the line vertices and triangles.
+
+    AddArrowHeadTriangles(StartArrowMesh, StartArrow);
+    AddArrowHeadTriangles(EndArrowMesh, EndArrow);
+    CalculateAllArrowHeadVertices();
+}
+
+bool FLineMeshBuilder::CanBuildRange(const FBezierCalc& Bezier, const FTessellationSplice& Splice) const
+{
+    // The mesh can only be spliced if it matches the tessellation from before the splice.
+
+    const int32 NumPoints = Bezier.Tessellated.Num();
+    const int32 Delta = (Splice.NewEnd - Splice.OldEnd) + (Splice.TrimNewEnd - Splice.TrimOldEnd) - Splice.Trimmed;
+    return NumPoints >= 2 && Line.Vertices.Num() == (LineStart + NumPoints - Delta) * 2 && Line.Uvs.Num() == Line.Vertices.Num();
+}
+
+bool FLineMeshBuilder::BuildRange(const FBezierCalc& Bezier, const FTessellationSplice& Splice)
+{
+    // Partial version of Build(), used after the partial calculations in FBezierCalc. The line
+    // vertices are spliced the same way as the tessellated points, and only the cross-lines that
+    // depend on the replaced points are recalculated. UVs follow the length along the line, so they
+    // are refreshed from the splice onwards. Trimmed points are left in front of the line, and only
+    // reclaimed once there are more of them than points in the line. Returns true if the points
+    // were moved to other places in Line. Check CanBuildRange() first.
+
+    const int32 NumPoints = Bezier.Tessellated.Num();
+    const int32 OldNumPoints = Line.Vertices.Num() / 2 - LineStart;
+    bool Moved = false;
+
+    // The new first segment goes into the room in front of the line, if there is enough.
+    LineStart += Splice.Trimmed;
+    const int32 TrimDelta = Splice.TrimNewEnd - Splice.TrimOldEnd;
+    if (TrimDelta <= LineStart) {
+        LineStart -= TrimDelta;
+    } else {
+        Line.Vertices.InsertUninitialized(LineStart * 2, TrimDelta * 2);
+        Line.Uvs.InsertUninitialized(LineStart * 2, TrimDelta * 2);
+        Moved = true;
+    }
+
+    const int32 Delta = Splice.NewEnd - Splice.OldEnd;
+    if (Delta > 0) {
+        Line.Vertices.InsertUninitialized((LineStart + Splice.OldEnd) * 2, Delta * 2);
+        Line.Uvs.InsertUninitialized((LineStart + Splice.OldEnd) * 2, Delta * 2);
+    } else if (Delta < 0) {
+        Line.Vertices.RemoveAt((LineStart + Splice.NewEnd) * 2, -Delta * 2, false);
+        Line.Uvs.RemoveAt((LineStart + Splice.NewEnd) * 2, -Delta * 2, false);
+    }
+
+    if (NumPoints != OldNumPoints) {
+        // Triangles follow the same pattern for every point, so only the ones for new points need
+        // to be filled in.
+        Line.Triangles.SetNum((NumPoints - 1) * 6);
+        CalculateLineTriangles(OldNumPoints - 1);
+    }
+
+    if (Splice.Trimmed > 0) {
+        // The new first point is now an end of the line, and its segment was tessellated again.
+        // The lengths after it are unchanged.
+        CalculateVertexRange(Bezier, 0, FMath::Min(Splice.TrimNewEnd, NumPoints - 1));
+        CalculateUvRange(Bezier, 0, FMath::Min(Splice.TrimNewEnd, NumPoints) - 1);
+    }
+
+    if (Splice.NewEnd > Splice.First) {
+        // Cross-lines are calculated from the previous and next points, so the points on either
+        // side of the splice are also affected.
+        CalculateVertexRange(Bezier, FMath::Max(Splice.First - 1, 0), FMath::Min(Splice.NewEnd, NumPoints - 1));
+        CalculateUvRange(Bezier, Splice.First, NumPoints - 1);
+    }
+
+    if (LineStart > NumPoints) {
+        Line.Vertices.RemoveAt(0, LineStart * 2, false);
+        Line.Uvs.RemoveAt(0, LineStart * 2, false);
+        LineStart = 0;
+        Moved = true;
+    }
+
+    CalculateAllArrowHeadVertices();
+    return Moved;
+}
+
+void FLineMeshBuilder::CalculateVertexPositions(const FBezierCalc& Bezier)
+{
+    if (Bezier.Points.Num() < 2 || Line.Vertices.Num() != (LineStart + Bezier.Tessellated.Num()) * 2) {
+        return;
+    }
+
+    CalculateVertexRange(Bezier, 0, Bezier.Tessellated.Num() - 1);
+    CalculateUvRange(Bezier, 0, Bezier.Tessellated.Num() - 1);
+}
+
+void FLineMeshBuilder::CalculateLineTriangles(const int32 FirstPoint)
+{
+    // Populate triangles. We end at < length-1, because the we reference the following index at
+    // each step.
+
+    const int32 NumPoints = Line.Triangles.Num() / 6 + 1;
+
+    for (int32 i = FMath::Max(FirstPoint, 0); i < NumPoints - 1; ++i) {
+        const int32 VertexBase = i * 2;
+        const int32 TriangleBase = i * 6;
+
+        Line.Triangles[TriangleBase + 0] = VertexBase;
+        Line.Triangles[TriangleBase + 1] = VertexBase + 1;
+        Line.Triangles[TriangleBase + 2] = VertexBase + 3;
+
+        Line.Triangles[TriangleBase + 3] = VertexBase;
+        Line.Triangles[TriangleBase + 4] = VertexBase + 3;
+        Line.Triangles[TriangleBase + 5] = VertexBase + 2;
+    }
+}
+
+void FLineMeshBuilder::CalculateVertexRange(const FBezierCalc& Bezier, const int32 FirstPoint, const int32 LastPoint)
+{
+    // Calculates the cross-line vertices for the tessellated points from FirstPoint to LastPoint.
+
+    const TLineTrimArray<FVector>& Tessellated = Bezier.Tessellated;
+
+    for (int32 i = FirstPoint; i <= LastPoint; ++i) {
+        // Load current, previous and next points. Some may be nullptr.
+        const FVector& CurPoint = Tessellated[i];
+        const int32 VertexBase = (LineStart + i) * 2;
+        const bool IsFirstPoint = (i == 0);
+        const bool IsLastPoint = (i == Tessellated.Num() - 1);
+
+        FVector PrevPoint = !IsFirstPoint ? Tessellated[i - 1] : FVector::ZeroVector;
+        FVector NextPoint = !IsLastPoint ? Tessellated[i + 1] : FVector::ZeroVector;
+
+        // Extend first and last point with fake, linear points.
+
+        if (IsFirstPoint) {
+            // Beginning point. Make fake, linear previous point.
+            PrevPoint = CurPoint - (NextPoint - CurPoint);
+        } else if (IsLastPoint) {
+            // Ending point. Make fake, linear next point.
+            NextPoint = CurPoint + (CurPoint - PrevPoint);
+        }
+
+        // UE_LOG(LogTemp, Log, TEXT("Previous: (%f, %f, %f), Current: (%f, %f, %f), Next: (%f, %f, %f)"), PrevPoint.X, PrevPoint.Y, PrevPoint.Z, CurPoint.X, CurPoint.Y, CurPoint.Z, NextPoint.X, NextPoint.Y, NextPoint.Z);
+
+        // Calculate cross-line. First, calculate the direction vectors
+        const FVector IncomingDirection = (CurPoint - PrevPoint).GetSafeNormal();
+        const FVector OutgoingDirection = (NextPoint - CurPoint).GetSafeNormal();
+
+        // Calculate the average direction
+        // const FVector AverageDirection = (IncomingDirection + OutgoingDirection).GetSafeNormal();
+        const FVector AverageDirection = (IncomingDirection + OutgoingDirection).GetSafeNormal();
+
+        // Calculate a direction perpendicular to both the average direction and the UpVector
+        const FVector PerpendicularDirection = FVector::CrossProduct(UpVector, AverageDirection).GetSafeNormal();
+
+        // Amplify line width in sharp corners. AngleDot is the cosine of the angle of the
+        // incoming/outgoing lines. We need to transform that into an actual angle (using Acos).
+        // Then we divide by 2, because we're interested in a 45 degree cross-line for a 90 degree
+        // turn. The Cos then maps it to an effective range of 0 to 1 for bent corners to straight
+        // lines. Clamped on the low end to prevent infinitely wide cross-lines in very sharp
+        // corners.
+        const float AngleDot = FVector::DotProduct(IncomingDirection, OutgoingDirection);
+        const float Factor = FMath::Clamp(FMath::Cos(FMath::Acos(AngleDot) / 2), 0.2, 1);
+        const float EffectiveLineWidth = LineWidth / Factor;
+        // UE_LOG(LogTemp, Log, TEXT("Angledot: %f, Acos(AngleDot): %f, FMath::Sin(FMath::Acos(AngleDot)/2): %f"), AngleDot, FMath::Acos(AngleDot), FMath::Sin(FMath::Acos(AngleDot)/2));
+
+        // Calculate the two points of the cross-line
+        const FVector C0 = CurPoint + PerpendicularDirection * (EffectiveLineWidth / 2);
+        const FVector C1 = CurPoint - PerpendicularDirection * (EffectiveLineWidth / 2);
+
+        // UE_LOG(LogTemp, Log, TEXT("Cross line (%f, %f, %f) to (%f, %f, %f)"), C0.X, C0.Y, C0.Z, C1.X, C1.Y, C1.Z);
+
+        Line.Vertices[VertexBase + 0] = C0;
+        Line.Vertices[VertexBase + 1] = C1;
+    }
+}
+
+void FLineMeshBuilder::CalculateUvRange(const FBezierCalc& Bezier, const int32 FirstPoint, const int32 LastPoint)
+{
+    // Set UVs. The U-axis of the UVs is left to right on the line, which simply goes 0 to 1.
+    // The V-axis is the distance along the line, read from the bezier's arc-length table. The table
+    // keeps its values while the line is trimmed, so the texture stays in place along the line.
+
+    for (int32 i = FirstPoint; i <= LastPoint; ++i) {
+        const int32 VertexBase = (LineStart + i) * 2;
+        const float Distance = Bezier.TessLengths[i];
+        Line.Uvs[VertexBase] = FVector2D(0, Distance / 100);
+        Line.Uvs[VertexBase + 1] = FVector2D(1, Distance / 100);
+    }
+}
+
+constexpr int32 ArrowRectLeftIndex = 0;
+constexpr int32 ArrowRectRightIndex = 1;
+constexpr int32 ArrowBarb1Index = 2;
+constexpr int32 ArrowBarb2Index = 3;
+constexpr int32 ArrowMiddleIndex = 4;
+constexpr int32 ArrowTipIndex = 5;
+
+void FLineMeshBuilder::AddArrowHeadTriangles(FLineMeshSection& ArrowMesh, const bool Active)
+{
+    if (Active) {
+        FLineScratchStats::Reserve(ArrowMesh.Vertices, 6);
+        FLineScratchStats::Reserve(ArrowMesh.Uvs, 6);
+        FLineScratchStats::Reserve(ArrowMesh.Triangles, 12);
+        ArrowMesh.Vertices.SetNumZeroed(6, false);
+        ArrowMesh.Uvs.SetNumZeroed(6, false);
+        ArrowMesh.Triangles.SetNumZeroed(12, false);
+
+        int32 TIndex = 0;
+        ArrowMesh.Triangles[TIndex + 0] = ArrowRectLeftIndex;
+        ArrowMesh.Triangles[TIndex + 1] = ArrowTipIndex;
+        ArrowMesh.Triangles[TIndex + 2] = ArrowBarb1Index;
+
+        TIndex += 3;
+        ArrowMesh.Triangles[TIndex + 0] = ArrowMiddleIndex;
+        ArrowMesh.Triangles[TIndex + 1] = ArrowTipIndex;
+        ArrowMesh.Triangles[TIndex + 2] = ArrowRectLeftIndex;
+
+        TIndex += 3;
+        ArrowMesh.Triangles[TIndex + 0] = ArrowMiddleIndex;
+        ArrowMesh.Triangles[TIndex + 1] = ArrowRectRightIndex;
+        ArrowMesh.Triangles[TIndex + 2] = ArrowTipIndex;
+
+        TIndex += 3;
+        ArrowMesh.Triangles[TIndex + 0] = ArrowRectRightIndex;
+        ArrowMesh.Triangles[TIndex + 1] = ArrowBarb2Index;
+        ArrowMesh.Triangles[TIndex + 2] = ArrowTipIndex;
+    } else {
+        ArrowMesh.Empty();
+    }
+}
+
+void FLineMeshBuilder::CalculateAllArrowHeadVertices()
+{
+    const int32 First = LineStart * 2;
+    if (Line.Vertices.Num() - First < 4) {
+        return;
+    }
+
+    if (StartArrow) {
+        CalculateArrowHeadVertices(StartArrowMesh, First + 3, First + 2, First + 1, First);
+    }
+
+    if (EndArrow) {
+        const int32 Last = Line.Vertices.Num() - 1;
+        CalculateArrowHeadVertices(EndArrowMesh, Last - 3, Last - 2, Last - 1, Last);
+    }
+}
+
+void FLineMeshBuilder::CalculateArrowHeadVertices(FLineMeshSection& ArrowMesh, const int32 N0, const int32 N1, const int32 N2, const int32 N3)
+{
+    // Input represents the vertex indexes of the rectangle at the end of the line. Resolve the
+    // points.
+    const TArray<FVector>& LineVertices = Line.Vertices;
+    const TArray<FVector2D>& LineUvs = Line.Uvs;
+    const FVector& P0 = LineVertices[N0];
+    const FVector& P1 = LineVertices[N1];
+    const FVector& P2 = LineVertices[N2];
+    const FVector& P3 = LineVertices[N3];
+
+    // Get the the middle point suspended between each cross-line.
+    const FVector M0 = (P0 + P1) / 2.0f;
+    const FVector M1 = (P2 + P3) / 2.0f;
+    const FVector2D M1Uv = (LineUvs[N2] + LineUvs[N3]) / 2;
+
+    ///// Calculate the barb on each side by extending out the cross-line, and moving it a bit back
+    ///// in the direction of the bezier line (the line going through M0 and M1).
+
+    // Extract line size and orientation
+    const FVector Direction = P3 - P2;
+    const float LineSize = Direction.Size();
+    const FVector NormalizedDirection = Direction.GetSafeNormal();
+
+    // Size the barb based on the line size and general scale of the arrow.
+    const float BarbSizeFactor = 2 * ArrowScale;
+    const float BackShiftFactor = 0.75f * ArrowScale;
+
+    // Extend barb out from ending line of rectangle.
+    const float ExtensionLength = LineSize * BarbSizeFactor;
+    FVector B0 = P2 - NormalizedDirection * ExtensionLength;
+    FVector B1 = P3 + NormalizedDirection * ExtensionLength;
+
+    // Calculate the back shift vector
+    const FVector BackShiftDirection = (M0 - M1).GetSafeNormal();
+    const float BackShiftLength = LineSize * BackShiftFactor;
+
+    // Shift B0 and B1 backwards towards M0. B0 and B1 are now the adjusted points.
+    B0 += BackShiftDirection * BackShiftLength;
+    B1 += BackShiftDirection * BackShiftLength;
+
+    ///// Calculate the tip by extending the line going through M0 and M1. Grab UV from the original
+    ///// ending edge in the rectangle.
+
+    const float TipSize = 3 * ArrowScale;
+    const FVector TipDirection = (M1 - M0).GetSafeNormal();
+    const float ExtPixels = LineSize * TipSize;
+    const FVector T0 = M1 + TipDirection * ExtPixels;
+    const float UvPolarity = (LineUvs[N2].Y > LineUvs[N0].Y) ? 1 : -1;
+    const FVector2D T0Uv((LineUvs[N2].X + LineUvs[N3].X) / 2, LineUvs[N2].Y + ExtPixels * UvPolarity / 100);
+
+    ///// Add to mesh. First add barb, middle and tip vertices. The two existing corners of the
+    ///// rectangle are at index N2 and N3.
+
+    ArrowMesh.Vertices[ArrowRectLeftIndex] = LineVertices[N2];
+    ArrowMesh.Uvs[ArrowRectLeftIndex] = LineUvs[N2]; // Copy from rectangle point that barb was extended from.
+
+    ArrowMesh.Vertices[ArrowRectRightIndex] = LineVertices[N3];
+    ArrowMesh.Uvs[ArrowRectRightIndex] = LineUvs[N3]; // Copy from rectangle point that barb was extended from.
+
+    ArrowMesh.Vertices[ArrowBarb1Index] = B0;
+    ArrowMesh.Uvs[ArrowBarb1Index] = ArrowMesh.Uvs[ArrowRectLeftIndex]; // Copy from rectangle point that barb was extended from.
+
+    ArrowMesh.Vertices[ArrowBarb2Index] = B1;
+    ArrowMesh.Uvs[ArrowBarb2Index] = ArrowMesh.Uvs[ArrowRectRightIndex]; // Copy from rectangle point that barb was extended from.
+
+    ArrowMesh.Vertices[ArrowMiddleIndex] = M1;
+    ArrowMesh.Uvs[ArrowMiddleIndex] = M1Uv;
+
+    ArrowMesh.Vertices[ArrowTipIndex] = T0;
+    ArrowMesh.Uvs[ArrowTipIndex] = T0Uv;
+}
@@ -0,0 +1,65 @@
+﻿// Copyright Hollywood Camera Work
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FBezierCalc;
+struct FTessellationSplice;
+
+// STRUCTS
+
+struct FLineMeshSection
+{
+    TArray<FVector> Vertices;
+    TArray<int32> Triangles;
+    TArray<FVector2D> Uvs;
+
+    void Empty();
+};
+
+// Vertices, triangles and UVs for a line and its arrowheads, calculated from a tessellated bezier.
+// Only reads the bezier and its own settings, so it can run on any thread. ULineMesh uploads the
+// result to its mesh sections.
+class LINERENDERER_API FLineMeshBuilder
+{
+    // METHODS
+
+    public: void Build(const FBezierCalc& Bezier);
+    public: bool CanBuildRange(const FBezierCalc& Bezier, const FTessellationSplice& Splice) const;
+    public: bool BuildRange(const FBezierCalc& Bezier, const FTessellationSplice& Splice);
+    public: void CalculateVertexPositions(const FBezierCalc& Bezier);
+    public: void CalculateAllArrowHeadVertices();
+
+    private: void CalculateLineTriangles(const int32 FirstPoint);
+    private: void CalculateVertexRange(const FBezierCalc& Bezier, const int32 FirstPoint, const int32 LastPoint);
+    private: void CalculateUvRange(const FBezierCalc& Bezier, const int32 FirstPoint, const int32 LastPoint);
+    private: static void AddArrowHeadTriangles(FLineMeshSection& ArrowMesh, const bool Active);
+    private: void CalculateArrowHeadVertices(FLineMeshSection& ArrowMesh, const int32 N0, const int32 N1, const int32 N2, const int32 N3);
+
+    // SETTINGS
+
+    public: FVector UpVector = FVector(0, 0, 1);
+    public: float LineWidth = 10;
+    public: bool StartArrow = false;
+    public: bool EndArrow = false;
+    public: float ArrowScale = 1;
+
+    // OUTPUT
+
+    public: FLineMeshSection Line;
+    // Points trimmed off the front of Line by BuildRange(), whose vertices and UVs are left in
+    // place in front of the first point. The triangles start from the first vertex regardless.
+    // Build() starts over from 0.
+    public: int32 LineStart = 0;
+    public: FLineMeshSection StartArrowMesh;
+    public: FLineMeshSection EndArrowMesh;
+};
+
+// A bezier and its mesh, built together away from the mesh component and handed over with
+// ULineMesh::CommitMesh().
+struct FLineBuild
+{
+    TSharedPtr<FBezierCalc> Bezier;
+    FLineMeshBuilder Geometry;
+};
@@ -0,0 +1,530 @@
+﻿// Copyright Hollywood Camera Work
+
+#include "LineMeshComponent.h"
+#include "BezierCalc.h"
+#include "LineMesh.h"
+#include "LineMeshBuilder.h"
+
+#include "DynamicMeshBuilder.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "LocalVertexFactory.h"
+#include "MaterialDomain.h"
+#include "Materials/Material.h"
+#include "PrimitiveSceneProxy.h"
+#include "PrimitiveViewRelevance.h"
+#include "RenderingThread.h"
+#include "SceneInterface.h"
+#include "SceneManagement.h"
+#include "StaticMeshResources.h"
+
+//
+// DYNAMIC VERTEX BUFFER
+//
+
+// Vertex buffer for data that is rewritten whenever the line changes, so it's created for dynamic
+// rather than static usage. Holds the initial data until the render thread has created it, and
+// the view that manual vertex fetch reads it through.
+class FLineMeshDynamicVertexBuffer final : public FVertexBuffer
+{
+    // METHODS
+
+    public: void Init(const void* Data, const int32 InNumVertices, const uint32 InStride, const EPixelFormat InFormat);
+    public: void Update_RenderThread(const void* Data);
+    public: virtual void InitRHI(FRHICommandListBase& RHICmdList) override;
+    public: virtual void ReleaseRHI() override;
+    public: FRHIShaderResourceView* GetSRV() const;
+
+    // PRIVATE PROPERTIES
+
+    private: TArray<uint8> InitialData;
+    private: FShaderResourceViewRHIRef SRV;
+    private: int32 NumVertices = 0;
+    private: uint32 Stride = 0;
+    private: EPixelFormat Format = PF_Unknown;
+};
+
+void FLineMeshDynamicVertexBuffer::Init(const void* Data, const int32 InNumVertices, const uint32 InStride, const EPixelFormat InFormat)
+{
+    NumVertices = InNumVertices;
+    Stride = InStride;
+    Format = InFormat;
+    InitialData.SetNumUninitialized(NumVertices * Stride);
+    FMemory::Memcpy(InitialData.GetData(), Data, InitialData.Num());
+}
+
+void FLineMeshDynamicVertexBuffer::InitRHI(FRHICommandListBase& RHICmdList)
+{
+    if (NumVertices == 0) {
+        return;
+    }
+
+    FRHIResourceCreateInfo CreateInfo(TEXT("FLineMeshDynamicVertexBuffer"));
+    VertexBufferRHI = RHICmdList.CreateVertexBuffer(NumVertices * Stride, BUF_Dynamic | BUF_ShaderResource, CreateInfo);
+    
+    void* Buffer = RHICmdList.LockBuffer(VertexBufferRHI, 0, NumVertices * Stride, RLM_WriteOnly);
+    FMemory::Memcpy(Buffer, InitialData.GetData(), NumVertices * Stride);
+    RHICmdList.UnlockBuffer(VertexBufferRHI);
+    InitialData.Empty();
+
+    // Read as individual components, like the engine's own vertex buffers.
+    SRV = RHICmdList.CreateShaderResourceView(VertexBufferRHI, GPixelFormats[Format].BlockBytes, Format);
+}
+
+void FLineMeshDynamicVertexBuffer::ReleaseRHI()
+{
+    SRV.SafeRelease();
+    FVertexBuffer::ReleaseRHI();
+}
+
+void FLineMeshDynamicVertexBuffer::Update_RenderThread(const void* Data)
+{
+    check(IsInRenderingThread());
+
+    if (!VertexBufferRHI.IsValid()) {
+        return;
+    }
+
+    void* Buffer = RHILockBuffer(VertexBufferRHI, 0, NumVertices * Stride, RLM_WriteOnly);
+    FMemory::Memcpy(Buffer, Data, NumVertices * Stride);
+    RHIUnlockBuffer(VertexBufferRHI);
+}
+
+FRHIShaderResourceView* FLineMeshDynamicVertexBuffer::GetSRV() const
+{
+    return SRV;
+}
+
+//
+// SCENE PROXY
+//
+
+class FLineMeshSceneProxy final : public FPrimitiveSceneProxy
+{
+    // METHODS
+
+    public: explicit FLineMeshSceneProxy(const ULineMeshComponent* Component);
+    public: virtual ~FLineMeshSceneProxy() override;
+    public: void UpdateStream_RenderThread(const FLineMeshStream& NewStream);
+    public: virtual void GetDynamicMeshElements(const TArray<const FSceneView*>& Views, const FSceneViewFamily& ViewFamily, uint32 VisibilityMap, FMeshElementCollector& Collector) const override;
+    public: virtual FPrimitiveViewRelevance GetViewRelevance(const FSceneView* View) const override;
+    public: virtual SIZE_T GetTypeHash() const override;
+    public: virtual uint32 GetMemoryFootprint() const override;
+    private: void AddBatch(FMeshElementCollector& Collector, const int32 ViewIndex, const FDynamicPrimitiveUniformBuffer& UniformBuffer, const FMaterialRenderProxy* Material, const int32 FirstIndex, const int32 Num) const;
+
+    // PROPERTIES
+
+    private: FLineMeshDynamicVertexBuffer PositionBuffer;
+    private: FLineMeshDynamicVertexBuffer UvBuffer;
+    private: FStaticMeshVertexBuffer TangentBuffer; // Tangents never change. Its UVs are unused.
+    private: FColorVertexBuffer ColorBuffer;
+    private: FDynamicMeshIndexBuffer32 IndexBuffer;
+    private: FLocalVertexFactory VertexFactory;
+    private: FMaterialRelevance MaterialRelevance;
+    private: UMaterialInterface* BodyMaterial = nullptr;
+    private: UMaterialInterface* ArrowMaterial = nullptr;
+    private: TArray<FBox3f> ChunkBounds;
+    private: int32 NumVertices = 0;
+    private: int32 NumIndices = 0;
+    private: int32 NumBodyIndices = 0;
+};
+
+FLineMeshSceneProxy::FLineMeshSceneProxy(const ULineMeshComponent* Component)
+    : FPrimitiveSceneProxy(Component)
+    , VertexFactory(GetScene().GetFeatureLevel(), "FLineMeshSceneProxy")
+    , MaterialRelevance(Component->GetMaterialRelevance(GetScene().GetFeatureLevel()))
+{
+    // The buffers are filled here, on the game thread, and initialized on the render thread. They
+    // don't keep a CPU copy, as updates are written straight into them. Positions and UVs are
+    // rewritten whenever the line changes, so they go in dynamic buffers.
+
+    const FLineMeshStream& Stream = *Component->GetStream();
+    NumVertices = Stream.Positions.Num();
+    NumIndices = Component->GetIndices().Num();
+    NumBodyIndices = Component->GetNumBodyIndices();
+    ChunkBounds = Stream.ChunkBounds;
+
+    // UVs are lengths along the line, which are too large for half precision.
+    PositionBuffer.Init(Stream.Positions.GetData(), NumVertices, sizeof(FVector3f), PF_R32_FLOAT);
+    UvBuffer.Init(Stream.Uvs.GetData(), NumVertices, sizeof(FVector2f), PF_G32R32F);
+    TangentBuffer.Init(NumVertices, 1, false);
+    ColorBuffer.InitFromSingleColor(FColor::White, NumVertices);
+
+    for (int32 i = 0; i < NumVertices; ++i) {
+        TangentBuffer.SetVertexTangents(i, FVector3f(1, 0, 0), FVector3f(0, 1, 0), FVector3f(0, 0, 1));
+    }
+
+    IndexBuffer.Indices = Component->GetIndices();
+
+    BeginInitResource(&PositionBuffer);
+    BeginInitResource(&UvBuffer);
+    BeginInitResource(&TangentBuffer);
+    BeginInitResource(&ColorBuffer);
+    BeginInitResource(&IndexBuffer);
+
+    FLineMeshSceneProxy* Self = this;
+    ENQUEUE_RENDER_COMMAND(InitLineMeshVertexFactory)([Self](FRHICommandListImmediate& RHICmdList) {
+        FLocalVertexFactory::FDataType Data;
+        Data.PositionComponent = FVertexStreamComponent(&Self->PositionBuffer, 0, sizeof(FVector3f), VET_Float3);
+        Data.PositionComponentSRV = Self->PositionBuffer.GetSRV();
+        Data.TextureCoordinates.Add(FVertexStreamComponent(&Self->UvBuffer, 0, sizeof(FVector2f), VET_Float2));
+        Data.TextureCoordinatesSRV = Self->UvBuffer.GetSRV();
+        Data.NumTexCoords = 1;
+        Self->TangentBuffer.BindTangentVertexBuffer(&Self->VertexFactory, Data);
+        Self->ColorBuffer.BindColorVertexBuffer(&Self->VertexFactory, Data);
+        Self->VertexFactory.SetData(Data);
+    });
+    BeginInitResource(&VertexFactory);
+
+    BodyMaterial = Component->GetMaterial(0);
+    if (BodyMaterial == nullptr) {
+        BodyMaterial = UMaterial::GetDefaultMaterial(MD_Surface);
+    }
+    ArrowMaterial = Component->GetMaterial(1);
+    if (ArrowMaterial == nullptr) {
+        ArrowMaterial = UMaterial::GetDefaultMaterial(MD_Surface);
+    }
+}
+
+FLineMeshSceneProxy::~FLineMeshSceneProxy()
+{
+    PositionBuffer.ReleaseResource();
+    UvBuffer.ReleaseResource();
+    TangentBuffer.ReleaseResource();
+    ColorBuffer.ReleaseResource();
+    IndexBuffer.ReleaseResource();
+    VertexFactory.ReleaseResource();
+}
+
+void FLineMeshSceneProxy::UpdateStream_RenderThread(const FLineMeshStream& NewStream)
+{
+    // The stream has the same layout as the position and UV buffers, so each is a single copy.
+    // ULineMeshComponent recreates the proxy instead when the number of vertices changes.
+
+    check(IsInRenderingThread());
+
+    if (NewStream.Positions.Num() != NumVertices || NumVertices == 0) {
+        return;
+    }
+
+    PositionBuffer.Update_RenderThread(NewStream.Positions.GetData());
+    UvBuffer.Update_RenderThread(NewStream.Uvs.GetData());
+
+    ChunkBounds = NewStream.ChunkBounds;
+}
+
+void FLineMeshSceneProxy::GetDynamicMeshElements(const TArray<const FSceneView*>& Views, const FSceneViewFamily& ViewFamily, uint32 VisibilityMap, FMeshElementCollector& Collector) const
+{
+    // Body chunks outside the view frustum are skipped. Runs of visible chunks are drawn as one
+    // batch, since their indices follow each other.
+
+    if (NumIndices == 0) {
+        return;
+    }
+
+    const FMaterialRenderProxy* BodyProxy = BodyMaterial->GetRenderProxy();
+    const FMaterialRenderProxy* ArrowProxy = ArrowMaterial->GetRenderProxy();
+    const int32 IndicesPerChunk = ULineMesh::PointsPerChunk * 6;
+
+    bool bHasPrecomputedVolumetricLightmap;
+    FMatrix PreviousLocalToWorld;
+    int32 SingleCaptureIndex;
+    bool bOutputVelocity;
+    GetScene().GetPrimitiveUniformShaderParameters_RenderThread(GetPrimitiveSceneInfo(), bHasPrecomputedVolumetricLightmap, PreviousLocalToWorld, SingleCaptureIndex, bOutputVelocity);
+    bOutputVelocity |= AlwaysHasVelocity();
+
+    for (int32 ViewIndex = 0; ViewIndex < Views.Num(); ++ViewIndex) {
+        if ((VisibilityMap & (1 << ViewIndex)) == 0) {
+            continue;
+        }
+        const FSceneView* View = Views[ViewIndex];
+
+        FDynamicPrimitiveUniformBuffer& UniformBuffer = Collector.AllocateOneFrameResource<FDynamicPrimitiveUniformBuffer>();
+        UniformBuffer.Set(GetLocalToWorld(), PreviousLocalToWorld, GetBounds(), GetLocalBounds(), GetLocalBounds(), true, bHasPrecomputedVolumetricLightmap, bOutputVelocity, GetCustomPrimitiveData());
+
+        int32 RunStart = INDEX_NONE;
+        for (int32 Chunk = 0; Chunk <= ChunkBounds.Num(); ++Chunk) {
+            bool Visible = false;
+            if (Chunk < ChunkBounds.Num()) {
+                const FBox WorldBounds = FBox(ChunkBounds[Chunk]).TransformBy(GetLocalToWorld());
+                Visible = View->ViewFrustum.IntersectBox(WorldBounds.GetCenter(), WorldBounds.GetExtent());
+            }
+
+            if (Visible && RunStart == INDEX_NONE) {
+                RunStart = Chunk;
+            } else if (!Visible && RunStart != INDEX_NONE) {
+                const int32 FirstIndex = RunStart * IndicesPerChunk;
+                const int32 EndIndex = FMath::Min(Chunk * IndicesPerChunk, NumBodyIndices);
+                AddBatch(Collector, ViewIndex, UniformBuffer, BodyProxy, FirstIndex, EndIndex - FirstIndex);
+                RunStart = INDEX_NONE;
+            }
+        }
+
+        if (NumIndices > NumBodyIndices) {
+            AddBatch(Collector, ViewIndex, UniformBuffer, ArrowProxy, NumBodyIndices, NumIndices - NumBodyIndices);
+        }
+    }
+}
+
+void FLineMeshSceneProxy::AddBatch(FMeshElementCollector& Collector, const int32 ViewIndex, const FDynamicPrimitiveUniformBuffer& UniformBuffer, const FMaterialRenderProxy* Material, const int32 FirstIndex, const int32 Num) const
+{
+    FMeshBatch& Mesh = Collector.AllocateMesh();
+    Mesh.VertexFactory = &VertexFactory;
+    Mesh.MaterialRenderProxy = Material;
+    Mesh.ReverseCulling = IsLocalToWorldDeterminantNegative();
+    Mesh.Type = PT_TriangleList;
+    Mesh.DepthPriorityGroup = SDPG_World;
+    Mesh.bCanApplyViewModeOverrides = false;
+
+    FMeshBatchElement& Element = Mesh.Elements[0];
+    Element.IndexBuffer = &IndexBuffer;
+    Element.PrimitiveUniformBufferResource = &UniformBuffer.UniformBuffer;
+    Element.FirstIndex = FirstIndex;
+    Element.NumPrimitives = Num / 3;
+    Element.MinVertexIndex = 0;
+    Element.MaxVertexIndex = NumVertices - 1;
+
+    Collector.AddMesh(ViewIndex, Mesh);
+}
+
+FPrimitiveViewRelevance FLineMeshSceneProxy::GetViewRelevance(const FSceneView* View) const
+{
+    FPrimitiveViewRelevance Result;
+    Result.bDrawRelevance = IsShown(View);
+    Result.bShadowRelevance = IsShadowCast(View);
+    Result.bDynamicRelevance = true;
+    Result.bRenderInMainPass = ShouldRenderInMainPass();
+    Result.bUsesLightingChannels = GetLightingChannelMask() != GetDefaultLightingChannelMask();
+    Result.bRenderCustomDepth = ShouldRenderCustomDepth();
+    MaterialRelevance.SetPrimitiveViewRelevance(Result);
+    Result.bVelocityRelevance = DrawsVelocity() && Result.bOpaque && Result.bRenderInMainPass;
+    return Result;
+}
+
+SIZE_T FLineMeshSceneProxy::GetTypeHash() const
+{
+    static size_t UniquePointer;
+    return reinterpret_cast<size_t>(&UniquePointer);
+}
+
+uint32 FLineMeshSceneProxy::GetMemoryFootprint() const
+{
+    return sizeof(*this) + GetAllocatedSize() + ChunkBounds.GetAllocatedSize();
+}
+
+//
+// COMPONENT
+//
+
+void ULineMeshComponent::SetGeometry(const FLineMeshBuilder& Geometry)
+{
+    // Converts the builder's vertices to the stream in one pass. If the number of vertices is the
+    // same, the stream is sent to the existing proxy. Otherwise the proxy is recreated with new
+    // indices. The stream is reused unless the render thread still has it.
+
+    if (!Stream.IsValid() || !Stream.IsUnique()) {
+        Stream = MakeShared<FLineMeshStream>();
+    }
+    FLineMeshStream& Out = *Stream;
+
+    const int32 NumBody = Geometry.Line.Vertices.Num();
+    const int32 NumStartArrow = Geometry.StartArrowMesh.Vertices.Num();
+    const int32 NumEndArrow = Geometry.EndArrowMesh.Vertices.Num();
+    Out.Positions.SetNumUninitialized(NumBody + NumStartArrow + NumEndArrow, false);
+    Out.Uvs.SetNumUninitialized(Out.Positions.Num(), false);
+
+    auto CopySection = [&Out](const FLineMeshSection& Section, const int32 Offset) {
+        for (int32 i = 0; i < Section.Vertices.Num(); ++i) {
+            Out.Positions[Offset + i] = FVector3f(Section.Vertices[i]);
+            Out.Uvs[Offset + i] = FVector2f(Section.Uvs[i]);
+        }
+    };
+    CopySection(Geometry.Line, 0);
+    CopySection(Geometry.StartArrowMesh, NumBody);
+    CopySection(Geometry.EndArrowMesh, NumBody + NumStartArrow);
+
+    // Chunk bounds cover the vertices that the chunk's triangles use, which includes the first
+    // point of the next chunk.
+
+    const int32 NumPoints = NumBody / 2;
+    const int32 NumChunks = NumPoints >= 2 ? FMath::DivideAndRoundUp(NumPoints - 1, ULineMesh::PointsPerChunk) : 0;
+    Out.ChunkBounds.SetNumUninitialized(NumChunks, false);
+    Out.Bounds = FBox3f(ForceInit);
+
+    for (int32 Chunk = 0; Chunk < NumChunks; ++Chunk) {
+        const int32 First = Chunk * ULineMesh::PointsPerChunk * 2;
+        const int32 Last = FMath::Min(First + ULineMesh::PointsPerChunk * 2 + 1, NumBody - 1);
+        FBox3f& Bounds = Out.ChunkBounds[Chunk];
+        Bounds = FBox3f(ForceInit);
+        for (int32 i = First; i <= Last; ++i) {
+            Bounds += Out.Positions[i];
+        }
+        Out.Bounds += Bounds;
+    }
+    for (int32 i = NumBody; i < Out.Positions.Num(); ++i) {
+        Out.Bounds += Out.Positions[i];
+    }
+
+    if (NumBody != NumBodyVertices || NumStartArrow != NumStartArrowVertices || NumEndArrow != NumEndArrowVertices) {
+        BuildIndices(Geometry);
+        MarkRenderStateDirty();
+    } else if (SceneProxy != nullptr) {
+        FLineMeshSceneProxy* Proxy = static_cast<FLineMeshSceneProxy*>(SceneProxy);
+        ENQUEUE_RENDER_COMMAND(UpdateLineMeshStream)([Proxy, Data = TSharedPtr<const FLineMeshStream>(Stream)](FRHICommandListImmediate& RHICmdList) {
+            Proxy->UpdateStream_RenderThread(*Data);
+        });
+    }
+
+    UpdateBounds();
+    MarkRenderTransformDirty();
+}
+
+void ULineMeshComponent::BuildIndices(const FLineMeshBuilder& Geometry)
+{
+    // The body's triangles, followed by the arrowheads', which are offset to where their vertices
+    // are in the stream.
+
+    NumBodyVertices = Geometry.Line.Vertices.Num();
+    NumStartArrowVertices = Geometry.StartArrowMesh.Vertices.Num();
+    NumEndArrowVertices = Geometry.EndArrowMesh.Vertices.Num();
+    NumBodyIndices = Geometry.Line.Triangles.Num();
+
+    Indices.Reset(NumBodyIndices + Geometry.StartArrowMesh.Triangles.Num() + Geometry.EndArrowMesh.Triangles.Num());
+
+    auto AddTriangles = [this](const FLineMeshSection& Section, const int32 Offset) {
+        for (const int32 Index : Section.Triangles) {
+            Indices.Add(static_cast<uint32>(Index + Offset));
+        }
+    };
+    AddTriangles(Geometry.Line, 0);
+    AddTriangles(Geometry.StartArrowMesh, NumBodyVertices);
+    AddTriangles(Geometry.EndArrowMesh, NumBodyVertices + NumStartArrowVertices);
+}
+
+FPrimitiveSceneProxy* ULineMeshComponent::CreateSceneProxy()
+{
+    if (!Stream.IsValid() || Indices.Num() == 0) {
+        return nullptr;
+    }
+    return new FLineMeshSceneProxy(this);
+}
+
+FBoxSphereBounds ULineMeshComponent::CalcBounds(const FTransform& LocalToWorld) const
+{
+    if (!Stream.IsValid() || !Stream->Bounds.IsValid) {
+        return FBoxSphereBounds(LocalToWorld.GetLocation(), FVector::ZeroVector, 0);
+    }
+    return FBoxSphereBounds(FBox(Stream->Bounds)).TransformBy(LocalToWorld);
+}
+
+int32 ULineMeshComponent::GetNumMaterials() const
+{
+    return 2;
+}
+
+const TArray<uint32>& ULineMeshComponent::GetIndices() const
+{
+    return Indices;
+}
+
+int32 ULineMeshComponent::GetNumBodyIndices() const
+{
+    return NumBodyIndices;
+}
+
+TSharedPtr<const FLineMeshStream> ULineMeshComponent::GetStream() const
+{
+    return Stream;
+}
+
+//
+// BENCHMARK
+//
+
+static void BenchmarkMeshUpload(const TArray<FString>& Args, UWorld* World)
+{
+    // Compares ULineMesh's procedural mesh upload with ULineMeshComponent on one long line. Both
+    // do the same vertex calculations, so the difference is the upload. Rendering commands are
+    // flushed inside the timings, so render thread work is included. Run with -nullrhi to measure
+    // the CPU side without the GPU.
+
+    const int32 NumPoints = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100000;
+    const int32 Iterations = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 20;
+    if (World == nullptr || NumPoints < 2 || Iterations < 1) {
+        UE_LOG(LogTemp, Warning, TEXT("Usage: LineRenderer.BenchmarkMeshUpload [NumPoints] [Iterations]"));
+        return;
+    }
+
+    // Hard corners, so the tessellation has exactly NumPoints points.
+    const TSharedPtr<FBezierCalc> Bezier = MakeShared<FBezierCalc>();
+    Bezier->HardCorners = true;
+    Bezier->Points.SetNumUninitialized(NumPoints);
+    for (int32 i = 0; i < NumPoints; ++i) {
+        Bezier->Points[i] = FVector(i * 10.0, (i % 2) * 10.0, 0);
+    }
+    Bezier->Calculate();
+
+    AActor* Host = World->SpawnActor<AActor>();
+    ULineMesh* ProcMesh = NewObject<ULineMesh>(Host);
+    Host->SetRootComponent(ProcMesh);
+    ProcMesh->RegisterComponent();
+    ProcMesh->Bezier = Bezier;
+    ULineMeshComponent* LineMesh = NewObject<ULineMeshComponent>(Host);
+    LineMesh->SetupAttachment(ProcMesh);
+    LineMesh->RegisterComponent();
+    FLineMeshBuilder Geometry;
+
+    auto Time = [World](auto&& Body) {
+        FlushRenderingCommands();
+        const double Start = FPlatformTime::Seconds();
+        Body();
+        World->SendAllEndOfFrameUpdates();
+        FlushRenderingCommands();
+        return (FPlatformTime::Seconds() - Start) * 1000.0;
+    };
+
+    double ProcMeshCreateMs = 0;
+    double ProcMeshUpdateMs = 0;
+    double LineMeshCreateMs = 0;
+    double LineMeshUpdateMs = 0;
+
+    for (int32 i = 0; i < Iterations; ++i) {
+        // Alternate the up vector, so every update changes the vertices.
+        const FVector UpVector = (i % 2 == 0) ? FVector(0, 0, 1) : FVector(0, 1, 0);
+
+        ProcMeshCreateMs += Time([ProcMesh]() {
+            ProcMesh->DataCycle++;
+            ProcMesh->CreateMesh();
+        });
+        ProcMeshUpdateMs += Time([ProcMesh, &UpVector]() {
+            ProcMesh->DataCycle++;
+            ProcMesh->UpVector = UpVector;
+            ProcMesh->UpdatePosition();
+        });
+
+        LineMeshCreateMs += Time([LineMesh, &Geometry, &Bezier]() {
+            Geometry.Build(*Bezier);
+            LineMesh->SetGeometry(Geometry);
+            LineMesh->MarkRenderStateDirty();
+        });
+        LineMeshUpdateMs += Time([LineMesh, &Geometry, &Bezier, &UpVector]() {
+            Geometry.UpVector = UpVector;
+            Geometry.CalculateVertexPositions(*Bezier);
+            Geometry.CalculateAllArrowHeadVertices();
+            LineMesh->SetGeometry(Geometry);
+        });
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("Mesh upload, %d points, average of %d: ProcMesh create %.2f ms, update %.2f ms. LineMeshComponent create %.2f ms, update %.2f ms."),
+        NumPoints, Iterations,
+        ProcMeshCreateMs / Iterations, ProcMeshUpdateMs / Iterations,
+        LineMeshCreateMs / Iterations, LineMeshUpdateMs / Iterations);
+
+    Host->Destroy();
+}
+
+static FAutoConsoleCommandWithWorldAndArgs BenchmarkMeshUploadCommand(
+    TEXT("LineRenderer.BenchmarkMeshUpload"),
+    TEXT("Times ULineMesh against ULineMeshComponent on a long line. Arguments: [NumPoints] [Iterations]"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkMeshUpload)
+);
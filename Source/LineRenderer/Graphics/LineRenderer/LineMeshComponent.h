@@ -0,0 +1,57 @@
+﻿// Copyright Hollywood Camera Work
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/MeshComponent.h"
+#include "LineMeshComponent.generated.h"
+
+class FLineMeshBuilder;
+
+// STRUCTS
+
+// Vertex data for ULineMeshComponent, in the same layout as its vertex buffers, so the render
+// thread copies it straight in. The line body comes first, then the start and end arrowheads.
+struct FLineMeshStream
+{
+    TArray<FVector3f> Positions;
+    TArray<FVector2f> Uvs;
+    TArray<FBox3f> ChunkBounds; // Local bounds of each body chunk, for culling them separately.
+    FBox3f Bounds = FBox3f(ForceInit);
+};
+
+// Alternative to ULineMesh's UProceduralMeshComponent upload. Has its own scene proxy that owns
+// the vertex and index buffers. Vertex updates are sent to the render thread as one compact stream
+// of positions and UVs, which is copied straight into the vertex buffers. The proxy is only
+// recreated when the number of vertices changes. The body is drawn in chunks of
+// ULineMesh::PointsPerChunk segments, which are culled separately. Material slot 0 is the body and
+// slot 1 the arrowheads.
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class LINERENDERER_API ULineMeshComponent : public UMeshComponent
+{
+    GENERATED_BODY()
+
+    // METHODS
+
+    public: void SetGeometry(const FLineMeshBuilder& Geometry);
+    public: virtual FPrimitiveSceneProxy* CreateSceneProxy() override;
+    public: virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
+    public: virtual int32 GetNumMaterials() const override;
+    public: const TArray<uint32>& GetIndices() const;
+    public: int32 GetNumBodyIndices() const;
+    public: TSharedPtr<const FLineMeshStream> GetStream() const;
+    private: void BuildIndices(const FLineMeshBuilder& Geometry);
+
+    // PRIVATE PROPERTIES
+
+    // The latest vertex data. Shared with the render thread until it has copied it, after which
+    // it's reused.
+    private: TSharedPtr<FLineMeshStream> Stream;
+
+    // Indices only change with the number of vertices.
+    private: TArray<uint32> Indices;
+    private: int32 NumBodyIndices = 0;
+    private: int32 NumBodyVertices = 0;
+    private: int32 NumStartArrowVertices = 0;
+    private: int32 NumEndArrowVertices = 0;
+};
@@ -1,625 +1,1587 @@
-﻿// Copyright Hollywood Camera Work
-
-#include "LineRendererActor.h"
-#include "CryptUtil.h"
-#include "LineMesh.h"
-#include "LineControlPoint.h"
-#include "BezierCalc.h"
-#include "Util/MathUtil.h"
-
-#ifndef ETOINT
-#define ETOINT(EnumValue) static_cast<int32>(static_cast<std::underlying_type<decltype(EnumValue)>::type>(EnumValue))
-#endif
-
-ALineRenderer::ALineRenderer()
-{
-    PrimaryActorTick.bCanEverTick = true;
-    LineMesh = nullptr;
-}
-
-void ALineRenderer::BeginPlay()
-{
-    Super::BeginPlay();
-    Init();
-}
-
-void ALineRenderer::Init()
-{
-    CreateLineMesh(false);
-    SetSideLineMeshQuantity(0);
-    SetControlPointQuantity(0);
-    ChangeDetection(true);
-}
-
-void ALineRenderer::Tick(const float DeltaTime)
-{
-    Super::Tick(DeltaTime);
-
-    if (CameraFacing) {
-        const APlayerCameraManager *CamManager = GetWorld()->GetFirstPlayerController()->PlayerCameraManager;
-        CameraLocation = CamManager->GetCameraLocation();
-        CameraForward  = CamManager->GetCameraRotation().Vector();
-
-        const float Dist = FVector::Dist(CameraLocation, OldCameraLocation);
-        const float Dot = FVector::DotProduct(CameraForward, OldCameraForward);
-
-        // If camera has moved or reoriented enough
-        if (Dist > 1 || Dot < 0.999) {
-            OldCameraLocation = CameraLocation;
-            OldCameraForward = CameraForward;
-            ChangeDetection();
-        }
-    }
-    
-    // UE_LOG(LogTemp, Log, TEXT("Camera location: %f,%f,%f. Forward: %f,%f,%f"), CamLocation.X, CamLocation.Y, CamLocation.Z, CamForward.X, CamForward.Y, CamForward.Z);
-}
-
-void ALineRenderer::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
-{
-    Super::PostEditChangeProperty(PropertyChangedEvent);
-    ChangeDetection();
-}
-
-void ALineRenderer::PostLoad()
-{
-    Super::PostLoad();
-    // Init();
-    // ChangeDetection();
-}
-
-//
-// SUBOBJECT LIFE-CYCLE
-//
-
-void ALineRenderer::CreateLineMesh(const bool ShouldExist)
-{
-    if (LineMesh == nullptr && ShouldExist) {
-        LineMesh = NewObject<ULineMesh>(this, ULineMesh::StaticClass(), TEXT("LineMesh"));
-        LineMesh->RegisterComponent();
-        LineMesh->AttachToComponent(RootComponent, FAttachmentTransformRules::KeepRelativeTransform);
-    }
-
-    if (LineMesh != nullptr && !ShouldExist) {
-        LineMesh->DestroyComponent();
-        LineMesh = nullptr;
-    }
-}
-
-void ALineRenderer::SetSideLineMeshQuantity(const int32 Desired)
-{
-    Lr_RemoveNullPointers(SideLineMeshes); // Hot reload protection
-    
-    while (SideLineMeshes.Num() < Desired) {
-        // if (GetOwner() == nullptr) {
-        //     UE_LOG(LogTemp, Warning, TEXT("Skipping SetSideLineMeshQuantity. No owner."));
-        //     break;
-        // }
-
-        ULineMesh* Mesh = NewObject<ULineMesh>(this, ULineMesh::StaticClass(), *FString::Printf(TEXT("SideLine_%d"), SideLineMeshes.Num()));
-        Mesh->RegisterComponent();
-        Mesh->AttachToComponent(RootComponent, FAttachmentTransformRules::KeepRelativeTransform);
-        SideLineMeshes.Add(Mesh);
-    }
-
-    while (SideLineMeshes.Num() > Desired) {
-        ULineMesh* Mesh = SideLineMeshes.Pop(true);
-        Mesh->DestroyComponent();
-    }
-}
-
-void ALineRenderer::SetControlPointQuantity(const int32 Desired)
-{
-    Lr_RemoveNullPointers(ControlPoints); // Hot reload protection
-
-    // UE_LOG(LogTemp, Log, TEXT("Setting control point quantity to %d"), Desired);
-    
-    while (ControlPoints.Num() < Desired) {
-        ULineControlPoint* ControlPoint = NewObject<ULineControlPoint>(this, ULineControlPoint::StaticClass(), *FString::Printf(TEXT("CP_%d"), ControlPoints.Num()));
-        ControlPoint->RegisterComponent();
-        ControlPoint->AttachToComponent(RootComponent, FAttachmentTransformRules::KeepRelativeTransform);
-        ControlPoints.Add(ControlPoint);
-        ControlPoint->Init();
-    }
-
-    while (ControlPoints.Num() > Desired) {
-        ULineControlPoint* ControlPoint = ControlPoints.Pop(true);
-        ControlPoint->DestroyComponent();
-    }
-}
-
-//
-// CHANGE DETECTION
-//
-
-void ALineRenderer::ChangeDetection(const bool Force)
-{
-    // Call change detection when done manipulating input parameters. While in the editor, this is
-    // called automatically when parameters are changed in the details panel.
-    
-    CreateLineMesh(true);
-    SetControlPointQuantity(ShowControlPoints ? Points.Num() : 0);
-    SetSideLineMeshQuantity(ShowSideLines ? SideLines.Num() : 0);
-
-    // New data cycle for all subobjects
-    
-    LineMesh->AutoInit();
-    LineMesh->DataCycle++;
-
-    for (const auto& Mesh: SideLineMeshes) {
-        Mesh->AutoInit();
-        Mesh->DataCycle++;
-    }
-
-    // ResetDebugLines();
-
-    EffectiveUpVector = CameraFacing ? (-CameraForward) : UpVector;
-    
-    // Do change detection backwards, and start at the latest phase needed.
-    
-    EPhases StartPhase = Force ? EPhases::Start : EPhases::End;
-
-    // Material change detection
-
-    if (ETOINT(StartPhase) > ETOINT(EPhases::Material)) {
-        TArray<uint8> Fingerprint = FCryptUtil::Fingerprint(
-            LineBodyColor,
-            ArrowheadColor,
-            SideLineColor,
-            static_cast<int32>(LineStyle),
-            static_cast<int32>(ArrowHeadStyle),
-            UvDensity,
-            AnimationSpeed,
-            ControlPointColor
-        );
-        if (!FCryptUtil::FingerprintMatch(Fingerprint, MaterialFingerprint)) {
-            MaterialFingerprint = MoveTemp(Fingerprint);
-            StartPhase = EPhases::Material;
-        }
-    }
-
-    // Position/orientation change detection
-
-    if (ETOINT(StartPhase) > ETOINT(EPhases::Position)) {
-        TArray<uint8> Fingerprint = FCryptUtil::Fingerprint(
-            CameraFacing,
-            EffectiveUpVector,
-            Points,
-            ShowControlPoints,
-            ControlPointScale, LineWidth // LineWidth is used by LineControlPoint
-        );
-        if (!FCryptUtil::FingerprintMatch(Fingerprint, PositionFingerprint)) {
-            PositionFingerprint = MoveTemp(Fingerprint);
-            StartPhase = EPhases::Position;
-        }
-    }
-
-    // Create mesh change detection
-
-    if (ETOINT(StartPhase) > ETOINT(EPhases::CreateMesh)) {
-        TArray<uint8> Fingerprint = FCryptUtil::Fingerprint(
-            LineWidth,
-            StartArrow,
-            EndArrow,
-            ArrowScale
-        );
-        if (!FCryptUtil::FingerprintMatch(Fingerprint, TessellationFingerprint)) {
-            TessellationFingerprint = MoveTemp(Fingerprint);
-            StartPhase = EPhases::CreateMesh;
-        }
-    }
-
-    // Points change detection (and tangent config)
-
-    if (ETOINT(StartPhase) > ETOINT(EPhases::Calculation)) {
-        // Pre-fingerprint the SideLine structs, to avoid having to read a FSideLine struct in
-        // FCryptUtil.
-        TArray<TArray<uint8>> SideLineFingerprints;
-        for (const FSideLine& SideLine : SideLines) {
-            auto [SideLineFrom, SideLineTo] = SideLine.GetFromTo();
-            auto [SideLineArrowStart, SideLineEndArrow] = SideLine.GetArrows();
-            SideLineFingerprints.Add(FCryptUtil::Fingerprint(
-                SideLineFrom,
-                SideLineTo,
-                SideLine.NotionalCameraVector,
-                SideLineArrowStart,
-                SideLineEndArrow
-            ));
-        }
-        
-        TArray<uint8> Fingerprint = FCryptUtil::Fingerprint(
-            Points,
-            SideLineFingerprints,
-            ShowSideLines,
-            HardCorners,
-            TessellationQuality,
-            TangentStrength
-        );
-        if (!FCryptUtil::FingerprintMatch(Fingerprint, LineFingerprint)) {
-            LineFingerprint = MoveTemp(Fingerprint);
-            StartPhase = EPhases::Calculation;
-        }
-    }
-
-    // Execute phases
-
-    if (ETOINT(EPhases::Calculation) >= ETOINT(StartPhase)) {
-        CalculateLineFundamentals();
-    }
-    
-    if (ETOINT(EPhases::CreateMesh) >= ETOINT(StartPhase)) {
-        CreateMesh();
-    }
-    
-    if (ETOINT(EPhases::Position) >= ETOINT(StartPhase)) {
-        UpdatePosition();
-    }
-    
-    if (ETOINT(EPhases::Material) >= ETOINT(StartPhase)) {
-        UpdateMaterials();
-    }
-}
-
-void ALineRenderer::CalculateLineFundamentals() const
-{
-    // UE_LOG(LogTemp, Log, TEXT("Calculate Line Fundamentals"));
-
-    // This needs to be upgraded so that sideline meshes receive offset and sectional points.
-    LineMesh->Bezier->Points = Points;
-    LineMesh->Bezier->HardCorners = HardCorners;
-    LineMesh->Bezier->TangentStrength = TangentStrength;
-    LineMesh->Bezier->TessellationQuality = TessellationQuality;
-    
-    // Calculation will have to be based on calculating the first line and then deriving the sidelines.
-    LineMesh->Bezier->Calculate();
-    
-    // LineMesh->Bezier->DumpTessellated();
-    // Mesh->DrawDebugTessellated();
-}
-
-void ALineRenderer::CreateMesh() const
-{
-    // UE_LOG(LogTemp, Log, TEXT("Create Mesh"));
-
-    LineMesh->UpVector = EffectiveUpVector; // Also needed for tessellation because orientations are calculated.
-    LineMesh->LineWidth = LineWidth;
-    LineMesh->StartArrow = StartArrow;
-    LineMesh->EndArrow = EndArrow;
-    LineMesh->ArrowScale = ArrowScale;
-    LineMesh->CreateMesh();
-}
-
-void ALineRenderer::UpdatePosition()
-{
-    // UE_LOG(LogTemp, Log, TEXT("Position/orientation"));
-
-    LineMesh->UpVector = EffectiveUpVector;
-    LineMesh->UpdatePosition();
-
-    CalculateSideLines();
-    
-    if (Points.Num() == ControlPoints.Num()) {
-        for (int32 i = 0; i < Points.Num(); ++i) {
-            const auto& ControlPoint = ControlPoints[i];
-            ControlPoint->Position = Points[i];
-            ControlPoint->ControlPointScale = ControlPointScale;
-            ControlPoint->UpdatePosition();
-        }
-    }
-}
-
-void ALineRenderer::UpdateMaterials()
-{
-    // UE_LOG(LogTemp, Log, TEXT("Material"));
-
-    LineMesh->LineStyle = LineStyle;
-    LineMesh->ArrowHeadStyle = ArrowHeadStyle;
-    LineMesh->Color1 = LineBodyColor;
-    LineMesh->Color2 = ArrowheadColor;
-    LineMesh->UvDensity = UvDensity;
-    LineMesh->AnimationSpeed = AnimationSpeed;
-    LineMesh->UpdateMaterial();
-
-    for (const auto& ControlPoint: ControlPoints) {
-        ControlPoint->ControlPointColor = ControlPointColor;
-        ControlPoint->UpdateMaterial();
-    }
-    
-    UpdateSidelineMaterials();
-}
-
-//
-// SIDELINES. These are Shot Designer-specific movement arrows that are rendered right next to the
-// main path to illustrate moving a camera back and forth on the same line. Sidelines are always
-// completely calculated during the Position/Orientation update, because orienting them towards the
-// camera involves sloping them differently against the main path depending on view angle.
-//
-
-void ALineRenderer::CalculateSideLines()
-{
-    if (LineMesh == nullptr) {
-        UE_LOG(LogTemp, Log, TEXT("No main line mesh. Cannot draw sidelines"));
-        return;
-    }
-
-    // UE_LOG(LogTemp, Log, TEXT("-------------------------------------------------"));
-
-    // Sidelines are only meant to be drawn in the camera diagram or when we're looking from above.
-    // Check if the camera is physically over any point on the main bezier (that the angle from a
-    // point up to the camera is close to world up).
-    bool AboveLine = false;
-    for (const FVector& Point: Points) {
-        const float Dot = FVector::DotProduct((CameraLocation - Point).GetSafeNormal(), FVector::UpVector);
-        if (Dot > 0.7) {
-            AboveLine = true;
-            break;
-        }
-    }
-    if (!(ShowSideLines && AboveLine)) {
-        SetSideLineMeshQuantity(0);
-        return;
-    }
-
-    // Sidelines are always drawn to be seen from above.
-    const FVector SideLineUpVector = FVector(0, 0, 1);
-    
-    SetSideLineMeshQuantity(SideLines.Num());
-    FBezierCalc& Bezier = *LineMesh->Bezier;
-    
-    TArray<FSideLine*> Stacking;
-
-    for (int i = 0; i < SideLines.Num(); ++i) {
-        FSideLine& SideLine = SideLines[i];
-        ULineMesh* SideLineMesh = SideLineMeshes[i];
-
-        auto [SideLineFrom, SideLineTo] = SideLine.GetFromTo();
-        auto [SideLineStartArrow, SideLineEndArrow] = SideLine.GetArrows();
-        
-        // Determine side. Get the standard perpendicular direction for the main bezier at this
-        // point. This will point to the left side of the line if looking along the line.
-        FVector StartPerpendicular = Bezier.PerpendicularAtPoint(SideLineFrom, SideLineUpVector);
-        float Side = 1;
-        
-        // Get dot-product of perpendicular vector and notional (assumed) camera angle. If greater
-        // than 0, they're pointing towards the same side, and we need to invert the side in order
-        // to try to get sidelines on the opposite sides that cameras are pointing.
-        if (FVector::DotProduct(StartPerpendicular, SideLine.NotionalCameraVector) > 0) {
-            Side = -1;
-        }
-
-        // Scan placed sidelines, and see if we can find a level where we can place this one. Any
-        // time we encounter a sideline with the same or lower level than us, set level to one above
-        // that level. At the end, we'll know which level is clear to place the current sideline on.
-        int32 Level = 0;
-
-        for (int j = 0; j < i; ++j) {
-            const FSideLine& CheckLine = SideLines[j];
-
-            if (CheckLine.Side != Side) {
-                // Ignore any lines not on the same side
-                continue;
-            }
-
-            constexpr float Margin = 0.05;
-
-            auto [CheckLineFrom, CheckLineTo] = CheckLine.GetFromTo();
-
-            if (SideLineTo + Margin <= CheckLineFrom || 
-                CheckLineTo <= SideLineFrom - Margin) {
-                // Ranges do not overlap, continue with the loop
-                continue;
-            }
-            
-            if (CheckLine.Level <= Level) {
-                // Move up to at least one above the tested level
-                Level = FMath::Max(Level, CheckLine.Level + 1);
-            }
-        }
-
-        SideLine.Side = Side;
-        SideLine.Level = Level;
-
-        // UE_LOG(LogTemp, Log, TEXT("From: %f, To: %f, Side: %d, Level: %d"), SideLineFrom, SideLineTo, SideLine.Side, SideLine.Level);
-
-        // Draw the sideline at the current Side and Level. Make an array of progress points that
-        // should get a control point, starting with the beginning and ending point, and any whole
-        // segment point in-between.
-
-        TArray<float> Progresses;
-        const float SnapFrom = FMath::Clamp(FMathUtil::SnapToWholeNumber(SideLineFrom, 0.02f), 0, Points.Num());
-        const float SnapTo = FMath::Clamp(FMathUtil::SnapToWholeNumber(SideLineTo, 0.02f), 0, Points.Num());
-        
-        Progresses.Add(SnapFrom);
-
-        const int32 WholeFrom = FMath::CeilToInt(SnapFrom + 0.000001);
-        const int32 WholeTo = FMath::FloorToInt(SnapTo - 0.000001);
-
-        for (int32 j = WholeFrom; j >= WholeFrom && j <= WholeTo; ++j) {
-            Progresses.Add(j);
-        }
-
-        Progresses.Add(SnapTo);
-
-        // for (const auto& Progress: Progresses) {
-        //     UE_LOG(LogTemp, Log, TEXT("Raw Progress: %f"), Progress);
-        // }
-
-        // Subdivide long spans of progress points, in order to ensure that the sideline reasonably
-        // follows the slope of the main line, even if it didn't start and end where the main line
-        // did and doesn't have the same tangents.
-
-        constexpr float MaxSpan = 0.1;
-        TArray<float> Subdivided;
-
-        for (int j = 0; j < Progresses.Num() - 1; ++j) {
-            const float& Current = Progresses[j];
-            const float& Next = Progresses[j + 1];
-
-            Subdivided.Add(Current);
-
-            const float Span = Next - Current;
-            if (Span > MaxSpan) {
-                const int NumPoints = static_cast<int>(Span / MaxSpan);
-                const float Step = Span / (NumPoints + 1);
-
-                for (int t = 1; t <= NumPoints; ++t) {
-                    Subdivided.Add(Current + t * Step);
-                }
-            }
-        }
-
-        Subdivided.Add(Progresses.Last());
-
-        // for (const float Sub: Subdivided) {
-        //     UE_LOG(LogTemp, Log, TEXT("Subdivided: %f"), Sub);
-        // }
-
-        // Create the points extended out from chosen side, the chosen distance. Discard points that
-        // are too close to the previous point, in order to prevent folding in sharp corners.
-
-        constexpr float Avoidance = 4; // Points can't be closer than this.
-        bool First = true;
-        FVector PrevPoint = FVector::ZeroVector;
-        TArray<FVector> FinalPoints;
-
-        for (const float Sub: Subdivided) {
-            // Calculate perpendicular point for this progress point.
-            FVector CurvePoint = Bezier.CalculateBezierPoint(Sub);
-            FVector Perpendicular = Bezier.PerpendicularAtPoint(Sub, SideLineUpVector);
-
-            // Perpendicular vectors can flip, so if the vector is more than 90 degrees wrong for
-            // the UpVector, we flip it.
-            // const float Flip = (FVector::DotProduct(Perpendicular, SideLineUpVector) < 0) ? -1 : 1;
-            constexpr float Flip = 1;
-            
-            // Calculate the point
-            FVector Point = CurvePoint + Perpendicular * SideLine.Side * Flip * (20 + 15 * SideLine.Level);
-            if (!First && (Point - PrevPoint).Size() < Avoidance) {
-                continue;
-            }
-
-            FinalPoints.Add(Point);
-            
-            First = false;
-            PrevPoint = Point;
-        }
-        
-        // for (const auto& Point: FinalPoints) {
-        //     UE_LOG(LogTemp, Log, TEXT("Point: %f,%f,%f"), Point.X, Point.Y, Point.Z);
-        // }
-
-        // Transfer points to line mesh
-
-        SideLineMesh->Bezier->Points.SetNum(FinalPoints.Num());
-        for (int32 t = 0; t < FinalPoints.Num(); ++t) {
-            SideLineMesh->Bezier->Points[t] = FinalPoints[t];
-        }
-
-        SideLineMesh->LineWidth = 1.5;
-        SideLineMesh->ArrowScale = 1;
-        SideLineMesh->UpVector = EffectiveUpVector;
-        SideLineMesh->StartArrow = SideLineStartArrow;
-        SideLineMesh->EndArrow = SideLineEndArrow;
-        SideLineMesh->Bezier->TessellationQuality = 0.98;
-        SideLineMesh->Bezier->HardCorners = false;
-        
-        SideLineMesh->Bezier->Calculate();
-        SideLineMesh->CreateMesh();
-    }
-}
-
-void ALineRenderer::UpdateSidelineMaterials()
-{
-    for (const auto& SideLineMesh: SideLineMeshes) {
-        SideLineMesh->Color1 = FLinearColor(0, 0, 0, 1);
-        SideLineMesh->UpdateMaterial();
-    }
-}
-
-std::tuple<float, float> FSideLine::GetFromTo() const
-{
-    // Observe that this is a method in FSideLine.
-    if (FromFloatProgress <= ToFloatProgress) {
-        return std::make_tuple(FromFloatProgress, ToFloatProgress);
-    } else {
-        return std::make_tuple(ToFloatProgress, FromFloatProgress);
-    }
-}
-
-std::tuple<bool, bool> FSideLine::GetArrows() const
-{
-    // Observe that this is a method in FSideLine.
-    if (FromFloatProgress <= ToFloatProgress) {
-        return std::make_tuple(StartArrow, EndArrow);
-    } else {
-        return std::make_tuple(EndArrow, StartArrow);
-    }
-}
-
-//
-// FORWARDERS
-//
-
-FVector ALineRenderer::CalculateLinearPoint(const float Progress) const
-{
-    // Forwarder to get linear position on bezier. Suitable for animation, because speed will be
-    // constant even with segments of varying lengths. Remember to call ChangeDetection() first.
-    
-    if (LineMesh != nullptr && LineMesh->Bezier.IsValid()) {
-        return LineMesh->Bezier->CalculateLinearPoint(Progress);
-    } else {
-        return FVector::ZeroVector;
-    }
-}
-
-FVector ALineRenderer::CalculateBezierPoint(const float Progress) const
-{
-    // Forwarder to get position on bezier based purely on segment + progress (e.g. Progress 1.7 for
-    // Segment 1 Progress 0.7). Not suitable for animation, as it doesn't compensate for segments of
-    // different lengths. Remember to call ChangeDetection() first.
-    
-    if (LineMesh != nullptr && LineMesh->Bezier.IsValid()) {
-        return LineMesh->Bezier->CalculateBezierPoint(Progress);
-    } else {
-        return FVector::ZeroVector;
-    }
-}
-
-FVector ALineRenderer::CalculateBezierPoint(const int32 Segment, const float Progress) const
-{
-    // Forwarder to get position on bezier based purely on segment and progress as separate values.
-    // Not suitable for animation, as it doesn't compensate for segments of different lengths.
-    // Remember to call ChangeDetection() first.
-    
-    if (LineMesh != nullptr && LineMesh->Bezier.IsValid()) {
-        return LineMesh->Bezier->CalculateBezierPoint(Segment, Progress);
-    } else {
-        return FVector::ZeroVector;
-    }
-}
-
-FHitDetectionResult ALineRenderer::HitDetectPoints(const APlayerController* Player, const FVector2D& HitPos) const
-{
-    if (LineMesh != nullptr && LineMesh->Bezier.IsValid()) {
-        return LineMesh->Bezier->HitDetectPoints(Player, HitPos);
-    } else {
-        return FHitDetectionResult{};
-    }
-}
-
-FHitDetectionResult ALineRenderer::HitDetectSpline(const APlayerController* Player, const FVector2D& HitPos) const
-{
-    if (LineMesh != nullptr && LineMesh->Bezier.IsValid()) {
-        return LineMesh->Bezier->HitDetectSpline(Player, HitPos);
-    } else {
-        return FHitDetectionResult{};
-    }
-}
-
-//
-// UTILITY
-//
-
-void ALineRenderer::ResetDebugLines() const
-{
-    FlushPersistentDebugLines(GetWorld());
-}
+﻿// Copyright Hollywood Camera Work
+
+#include "LineRendererActor.h"
+#include "LineRendererIncludes.h"
+#include "CryptUtil.h"
+#include "LineMesh.h"
+#include "LineControlPoints.h"
+#include "BezierCalc.h"
+#include "LineHitQueryContext.h"
+#include "LineRendererSubsystem.h"
+#include "Util/MathUtil.h"
+#include "Misc/MemStack.h"
+#include "Algo/BinarySearch.h"
+#include "Algo/Sort.h"
+
+#include <atomic>
+
+// Inputs and results of one background build. Everything the worker needs is copied in when the
+// build is launched, so it never reads the actor or its components.
+struct FLineBuildJob
+{
+    std::atomic<bool> Cancelled = false;
+    bool Recalculate = false; // If false, Line.Bezier is the line's current bezier, which is only read.
+    bool BuildSideLines = false;
+    int32 NumPoints = 0;
+    FVector UpVector = FVector(0, 0, 1);
+    TArray<FSideLine> SideLines;
+
+    FLineBuild Line;
+    TArray<FLineBuild> SideLineBuilds;
+};
+
+ALineRenderer::ALineRenderer()
+{
+    // Camera facing is driven by ULineRendererSubsystem, so ticking is off unless opted into.
+    PrimaryActorTick.bCanEverTick = true;
+    PrimaryActorTick.bStartWithTickEnabled = false;
+    LineMesh = nullptr;
+}
+
+void ALineRenderer::BeginPlay()
+{
+    Super::BeginPlay();
+    SetActorTickEnabled(EnableActorTick);
+
+    if (ULineRendererSubsystem* Subsystem = GetWorld()->GetSubsystem<ULineRendererSubsystem>()) {
+        Subsystem->RegisterLine(this);
+    }
+    
+    Init();
+}
+
+void ALineRenderer::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    CancelAsyncBuild();
+    UpdatePending = false;
+    
+    if (ULineRendererSubsystem* Subsystem = GetWorld()->GetSubsystem<ULineRendererSubsystem>()) {
+        Subsystem->UnregisterLine(this);
+    }
+    
+    Super::EndPlay(EndPlayReason);
+}
+
+void ALineRenderer::Init()
+{
+    CreateLineMesh(false);
+    SetSideLineMeshQuantity(0);
+    SetControlPointQuantity(0);
+    ChangeDetection(true);
+}
+
+void ALineRenderer::Tick(const float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+}
+
+bool ALineRenderer::NeedsCameraUpdate(const FVector& Location, const FVector& Forward) const
+{
+    // If camera has moved or reoriented enough since the line was last oriented.
+    
+    const float Dist = FVector::Dist(Location, OldCameraLocation);
+    const float Dot = FVector::DotProduct(Forward, OldCameraForward);
+    return Dist > 1 || Dot < 0.999;
+}
+
+float ALineRenderer::OrientationError(const FVector& Location, const FVector& Forward, const float Distance) const
+{
+    // Roughly how far off, in radians, the line looks from a camera at Location, given that it was
+    // last oriented for the old camera. Turning the camera tilts the line directly. Moving it
+    // changes the view angle by about the distance moved over the distance to the line.
+
+    const float Dot = FVector::DotProduct(Forward, OldCameraForward);
+    const float Turn = FMath::Acos(FMath::Clamp(Dot, -1.0f, 1.0f));
+    const float Move = FVector::Dist(Location, OldCameraLocation) / FMath::Max(Distance, 1.0f);
+    return Turn + Move;
+}
+
+void ALineRenderer::UpdateCamera(const FVector& Location, const FVector& Forward)
+{
+    // Called by ULineRendererSubsystem, which reads the camera once per frame for all lines.
+    
+    CameraLocation = Location;
+    CameraForward = Forward;
+
+    if (NeedsCameraUpdate(CameraLocation, CameraForward)) {
+        OldCameraLocation = CameraLocation;
+        OldCameraForward = CameraForward;
+
+        // The camera decides the orientation of camera facing lines and whether sidelines show,
+        // which are both part of the position phase. The pass is fingerprinted, so properties
+        // written directly outside of BeginUpdate()/EndUpdate() are picked up here too.
+        MarkDirty(EPhases::Position);
+        ChangeDetection();
+    }
+    
+    // UE_LOG(LogTemp, Log, TEXT("Camera location: %f,%f,%f. Forward: %f,%f,%f"), CamLocation.X, CamLocation.Y, CamLocation.Z, CamForward.X, CamForward.Y, CamForward.Z);
+}
+
+void ALineRenderer::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+    // The member property is the top level one, e.g. SideLines when a field in one of them was
+    // edited. Anything not in the property table is fingerprinted.
+    
+    Super::PostEditChangeProperty(PropertyChangedEvent);
+    PropertyChanged(PropertyChangedEvent.GetMemberPropertyName());
+}
+
+void ALineRenderer::PostLoad()
+{
+    Super::PostLoad();
+    // Init();
+    // ChangeDetection();
+}
+
+//
+// SUBOBJECT LIFE-CYCLE
+//
+
+void ALineRenderer::CreateLineMesh(const bool ShouldExist)
+{
+    if (LineMesh == nullptr && ShouldExist) {
+        LineMesh = NewObject<ULineMesh>(this, ULineMesh::StaticClass(), TEXT("LineMesh"));
+        LineMesh->RegisterComponent();
+        LineMesh->AttachToComponent(RootComponent, FAttachmentTransformRules::KeepRelativeTransform);
+    }
+
+    if (LineMesh != nullptr && !ShouldExist) {
+        LineMesh->DestroyComponent();
+        LineMesh = nullptr;
+    }
+}
+
+void ALineRenderer::SetSideLineMeshQuantity(const int32 Desired)
+{
+    Lr_RemoveNullPointers(SideLineMeshes); // Hot reload protection
+    
+    while (SideLineMeshes.Num() < Desired) {
+        // if (GetOwner() == nullptr) {
+        //     UE_LOG(LogTemp, Warning, TEXT("Skipping SetSideLineMeshQuantity. No owner."));
+        //     break;
+        // }
+
+        ULineMesh* Mesh = NewObject<ULineMesh>(this, ULineMesh::StaticClass(), *FString::Printf(TEXT("SideLine_%d"), SideLineMeshes.Num()));
+        Mesh->RegisterComponent();
+        Mesh->AttachToComponent(RootComponent, FAttachmentTransformRules::KeepRelativeTransform);
+        SideLineMeshes.Add(Mesh);
+        SideLineLayoutDirty = true; // New meshes have no geometry yet.
+    }
+
+    while (SideLineMeshes.Num() > Desired) {
+        ULineMesh* Mesh = SideLineMeshes.Pop(true);
+        Mesh->DestroyComponent();
+        SideLineLayoutDirty = true;
+    }
+}
+
+void ALineRenderer::SetControlPointQuantity(const int32 Desired)
+{
+    // UE_LOG(LogTemp, Log, TEXT("Setting control point quantity to %d"), Desired);
+
+    // All control points are instances of one component, created the first time any are shown.
+    // It's kept when they're hidden again.
+    
+    if (!IsValid(ControlPoints)) { // Hot reload protection
+        if (Desired == 0) {
+            ControlPoints = nullptr;
+            return;
+        }
+        ControlPoints = NewObject<ULineControlPoints>(this, ULineControlPoints::StaticClass(), TEXT("ControlPoints"));
+        ControlPoints->Init();
+        ControlPoints->RegisterComponent();
+        ControlPoints->AttachToComponent(RootComponent, FAttachmentTransformRules::KeepRelativeTransform);
+        ControlPoints->ControlPointColor = ControlPointColor;
+        ControlPoints->UpdateMaterial();
+    }
+
+    ControlPoints->SetQuantity(Desired);
+}
+
+//
+// CHANGE DETECTION
+//
+
+void ALineRenderer::ChangeDetection(const bool Force, const bool CheckFingerprints)
+{
+    // Call change detection when done manipulating input parameters. While in the editor, this is
+    // called automatically when parameters are changed in the details panel. Phases marked dirty by
+    // setters always run. Fingerprinting catches properties that were written directly, and can be
+    // skipped when everything went through setters. Phases that run are always fingerprinted, so
+    // the fingerprints match what was last applied. The points aren't fingerprinted, as the bezier
+    // already holds the ones it was calculated from, so setters never pay for hashing them.
+    
+    CreateLineMesh(true);
+    SetControlPointQuantity(ShowControlPoints ? Points.Num() : 0);
+    SetSideLineMeshQuantity(ShowSideLines ? SideLines.Num() : 0);
+
+    // New data cycle for all subobjects
+    
+    LineMesh->AutoInit();
+    LineMesh->DataCycle++;
+
+    for (const auto& Mesh: SideLineMeshes) {
+        Mesh->AutoInit();
+        Mesh->DataCycle++;
+    }
+
+    // ResetDebugLines();
+
+    EffectiveUpVector = CameraFacing ? (-CameraForward) : UpVector;
+    
+    // Do change detection backwards, and start at the latest phase needed.
+    
+    EPhases StartPhase = Force ? EPhases::Start : DirtyPhase;
+    DirtyPhase = EPhases::End;
+
+    // Mesh settings changes rule out updating only part of the mesh.
+    bool MeshSettingsChanged = Force || MeshSettingsDirty;
+    MeshSettingsDirty = false;
+
+    // Material change detection
+
+    if (CheckFingerprints || ETOINT(StartPhase) <= ETOINT(EPhases::Material)) {
+        const uint64 Fingerprint = FCryptUtil::Fingerprint(
+            LineBodyColor,
+            ArrowheadColor,
+            SideLineColor,
+            static_cast<int32>(LineStyle),
+            static_cast<int32>(ArrowHeadStyle),
+            UvDensity,
+            AnimationSpeed,
+            ControlPointColor,
+            ParametersInPrimitiveData
+        );
+        if (!FCryptUtil::FingerprintMatch(Fingerprint, MaterialFingerprint)) {
+            MaterialFingerprint = Fingerprint;
+            StartPhase = ETOINT(StartPhase) < ETOINT(EPhases::Material) ? StartPhase : EPhases::Material;
+        }
+    }
+
+    // Position/orientation change detection
+
+    if (CheckFingerprints || ETOINT(StartPhase) <= ETOINT(EPhases::Position)) {
+        const uint64 Fingerprint = FCryptUtil::Fingerprint(
+            CameraFacing,
+            EffectiveUpVector,
+            ShowControlPoints,
+            ControlPointScale, LineWidth // LineWidth is used by LineControlPoints
+        );
+        if (!FCryptUtil::FingerprintMatch(Fingerprint, PositionFingerprint)) {
+            PositionFingerprint = Fingerprint;
+            StartPhase = ETOINT(StartPhase) < ETOINT(EPhases::Position) ? StartPhase : EPhases::Position;
+        }
+    }
+
+    // Create mesh change detection
+
+    if (CheckFingerprints || ETOINT(StartPhase) <= ETOINT(EPhases::CreateMesh)) {
+        const uint64 Fingerprint = FCryptUtil::Fingerprint(
+            LineWidth,
+            StartArrow,
+            EndArrow,
+            ArrowScale
+        );
+        if (!FCryptUtil::FingerprintMatch(Fingerprint, TessellationFingerprint)) {
+            TessellationFingerprint = Fingerprint;
+            StartPhase = ETOINT(StartPhase) < ETOINT(EPhases::CreateMesh) ? StartPhase : EPhases::CreateMesh;
+            MeshSettingsChanged = true;
+        }
+    }
+
+    // Sideline change detection
+
+    if (CheckFingerprints || ETOINT(StartPhase) <= ETOINT(EPhases::Calculation)) {
+        const uint64 Fingerprint = SideLineInputFingerprint();
+        if (!FCryptUtil::FingerprintMatch(Fingerprint, SideLineFingerprint)) {
+            SideLineFingerprint = Fingerprint;
+            StartPhase = ETOINT(StartPhase) < ETOINT(EPhases::Calculation) ? StartPhase : EPhases::Calculation;
+        }
+    }
+
+    // Points change detection (and tangent config). Only needed if nothing else has scheduled the
+    // calculation yet.
+
+    if (CheckFingerprints && ETOINT(StartPhase) > ETOINT(EPhases::Calculation) && BezierInputsChanged()) {
+        StartPhase = EPhases::Calculation;
+    }
+
+    // Execute phases. The sidelines are laid out from the line, so recalculating it also means
+    // building them again.
+
+    if (ETOINT(EPhases::Calculation) >= ETOINT(StartPhase)) {
+        SideLineLayoutDirty = true;
+    }
+
+    if (UseAsyncBuild()) {
+        if (ETOINT(EPhases::Position) >= ETOINT(StartPhase)) {
+            // The bezier, mesh and sidelines are built on a worker thread and committed by
+            // ULineRendererSubsystem when done. Control points are only moved, so that happens now.
+            LaunchAsyncBuild(ETOINT(EPhases::Calculation) >= ETOINT(StartPhase));
+            UpdateControlPoints();
+        }
+    } else {
+        if (PendingBuild.IsValid()) {
+            // Switched to synchronous updates while a build was running. Redo what it would have done.
+            const EPhases PendingPhase = PendingBuild->Recalculate ? EPhases::Calculation : EPhases::CreateMesh;
+            StartPhase = ETOINT(PendingPhase) < ETOINT(StartPhase) ? PendingPhase : StartPhase;
+            CancelAsyncBuild();
+        }
+        
+        if (ETOINT(EPhases::Calculation) >= ETOINT(StartPhase)) {
+            CalculateLineFundamentals(!Force);
+            UpdateBounds();
+        }
+
+        if (ETOINT(EPhases::CreateMesh) >= ETOINT(StartPhase)) {
+            CreateMesh(MeshSettingsChanged);
+        }
+
+        if (ETOINT(EPhases::Position) >= ETOINT(StartPhase)) {
+            UpdatePosition();
+        }
+    }
+    
+    if (ETOINT(EPhases::Material) >= ETOINT(StartPhase)) {
+        UpdateMaterials();
+    }
+}
+
+void ALineRenderer::PropertyChanged(const FName PropertyName)
+{
+    // Marks only the phases the property invalidates. Unknown properties fall back to
+    // fingerprinting everything.
+    
+    EPhases Phase;
+    if (PhaseForProperty(PropertyName, Phase)) {
+        MarkDirty(Phase);
+    } else {
+        PendingFingerprintCheck = true;
+    }
+    RequestUpdate();
+}
+
+void ALineRenderer::RequestUpdate()
+{
+    // In game worlds the update is queued with ULineRendererSubsystem, which ticks after all actors
+    // have, so every change to the line this frame is applied in one pass. Elsewhere, e.g. in the
+    // editor or before BeginPlay() has registered the line, it runs right away.
+    
+    if (UpdateDepth > 0) {
+        return;
+    }
+
+    UWorld* World = GetWorld();
+    ULineRendererSubsystem* Subsystem = (World != nullptr && World->IsGameWorld()) ? World->GetSubsystem<ULineRendererSubsystem>() : nullptr;
+    if (Subsystem == nullptr || !Subsystem->IsRegistered(this)) {
+        FlushUpdates();
+        return;
+    }
+
+    if (!UpdatePending) {
+        UpdatePending = true;
+        Subsystem->AddPendingUpdate(this);
+    }
+}
+
+void ALineRenderer::MarkDirty(const EPhases Phase)
+{
+    if (ETOINT(Phase) < ETOINT(DirtyPhase)) {
+        DirtyPhase = Phase;
+    }
+    if (Phase == EPhases::CreateMesh) {
+        MeshSettingsDirty = true;
+    }
+}
+
+bool ALineRenderer::PhaseForProperty(const FName PropertyName, EPhases& OutPhase)
+{
+    // The earliest phase each property invalidates. This must agree with what the fingerprints in
+    // ChangeDetection() cover. Properties that don't affect the line map to End.
+
+    struct FPropertyPhase
+    {
+        const TCHAR* Name;
+        EPhases Phase;
+    };
+
+    static constexpr FPropertyPhase PropertyPhases[] = {
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, Points), EPhases::Calculation},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, HardCorners), EPhases::Calculation},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, TessellationQuality), EPhases::Calculation},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, TangentStrength), EPhases::Calculation},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, ShowSideLines), EPhases::Calculation},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, SideLines), EPhases::Calculation},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, LineWidth), EPhases::CreateMesh},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, StartArrow), EPhases::CreateMesh},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, EndArrow), EPhases::CreateMesh},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, ArrowScale), EPhases::CreateMesh},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, CameraFacing), EPhases::Position},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, UpVector), EPhases::Position},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, ShowControlPoints), EPhases::Position},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, ControlPointScale), EPhases::Position},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, LineBodyColor), EPhases::Material},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, ArrowheadColor), EPhases::Material},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, SideLineColor), EPhases::Material},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, LineStyle), EPhases::Material},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, ArrowHeadStyle), EPhases::Material},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, UvDensity), EPhases::Material},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, AnimationSpeed), EPhases::Material},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, ControlPointColor), EPhases::Material},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, ParametersInPrimitiveData), EPhases::Material},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, MaxPoints), EPhases::End},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, EnableActorTick), EPhases::End},
+        {GET_MEMBER_NAME_STRING_CHECKED(ALineRenderer, AsyncUpdates), EPhases::End},
+    };
+
+    for (const FPropertyPhase& Entry : PropertyPhases) {
+        if (PropertyName == Entry.Name) {
+            OutPhase = Entry.Phase;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64 ALineRenderer::SideLineInputFingerprint() const
+{
+    // Everything about the sidelines that their layout depends on. The SideLine structs are
+    // streamed in field by field, to avoid having to read a FSideLine struct in FCryptUtil.
+    
+    FFingerprintBuilder Builder;
+    Builder.Add(SideLines.Num());
+    for (const FSideLine& SideLine : SideLines) {
+        auto [SideLineFrom, SideLineTo] = SideLine.GetFromTo();
+        auto [SideLineArrowStart, SideLineEndArrow] = SideLine.GetArrows();
+        Builder.Add(SideLineFrom);
+        Builder.Add(SideLineTo);
+        Builder.Add(SideLine.NotionalCameraVector);
+        Builder.Add(SideLineArrowStart);
+        Builder.Add(SideLineEndArrow);
+    }
+    Builder.Add(ShowSideLines);
+    return Builder.Finalize();
+}
+
+bool ALineRenderer::BezierInputsChanged() const
+{
+    // Compares the points and bezier settings with the ones the latest calculation was made from.
+    // That's the pending background build's bezier if it recalculates, and the line's otherwise.
+
+    const FBezierCalc* Bezier = (PendingBuild.IsValid() && PendingBuild->Recalculate) ? PendingBuild->Line.Bezier.Get() : LineMesh->Bezier.Get();
+    return Bezier == nullptr ||
+        Bezier->HardCorners != HardCorners ||
+        Bezier->TangentStrength != TangentStrength ||
+        Bezier->TessellationQuality != TessellationQuality ||
+        Bezier->Points.Num() != Points.Num() ||
+        !CompareItems(Bezier->Points.GetData(), Points.GetData(), Points.Num());
+}
+
+void ALineRenderer::CalculateLineFundamentals(const bool AllowIncremental)
+{
+    // UE_LOG(LogTemp, Log, TEXT("Calculate Line Fundamentals"));
+
+    if (!LineMesh->Bezier.IsUnique()) {
+        // A background build that was cancelled may still be reading it.
+        FLineScratchStats::CountAllocation();
+        LineMesh->Bezier = MakeShared<FBezierCalc>(*LineMesh->Bezier);
+    }
+    
+    FBezierCalc& Bezier = *LineMesh->Bezier;
+    IncrementalTessellation = false;
+
+    const int32 Trimmed = StreamTrimmed;
+    StreamTrimmed = 0;
+
+    if (AllowIncremental && CalculateStreamed(Bezier, Trimmed)) {
+        IncrementalTessellation = true;
+        return;
+    }
+
+    // Find the range of points that moved since the last calculation. If it's only a few points,
+    // and nothing else about the bezier changed, only the segments around them are recalculated.
+    // This keeps dragging single points on long lines interactive.
+    
+    const bool SameSettings =
+        Bezier.Points.Num() == Points.Num() &&
+        Bezier.HardCorners == HardCorners &&
+        Bezier.TangentStrength == TangentStrength &&
+        Bezier.TessellationQuality == TessellationQuality;
+
+    int32 FirstChanged = INDEX_NONE;
+    int32 LastChanged = INDEX_NONE;
+
+    if (AllowIncremental && SameSettings) {
+        for (int32 i = 0; i < Points.Num(); ++i) {
+            if (Bezier.Points[i] != Points[i]) {
+                FirstChanged = (FirstChanged == INDEX_NONE) ? i : FirstChanged;
+                LastChanged = i;
+            }
+        }
+    }
+
+    // This needs to be upgraded so that sideline meshes receive offset and sectional points.
+    Bezier.Points = Points;
+    Bezier.HardCorners = HardCorners;
+    Bezier.TangentStrength = TangentStrength;
+    Bezier.TessellationQuality = TessellationQuality;
+
+    if (AllowIncremental && SameSettings && FirstChanged == INDEX_NONE && Bezier.Tessellated.Num() > 0) {
+        // Only something other than the bezier changed (e.g. sidelines).
+        TessellationSplice = FTessellationSplice();
+        IncrementalTessellation = true;
+    } else if (FirstChanged != INDEX_NONE && (LastChanged - FirstChanged + 1) * 4 <= Points.Num()) {
+        IncrementalTessellation = Bezier.CalculateRange(FirstChanged, LastChanged, TessellationSplice);
+    }
+
+    if (!IncrementalTessellation) {
+        // Calculation will have to be based on calculating the first line and then deriving the sidelines.
+        Bezier.Calculate();
+    }
+    
+    // LineMesh->Bezier->DumpTessellated();
+    // Mesh->DrawDebugTessellated();
+}
+
+bool ALineRenderer::CalculateStreamed(FBezierCalc& Bezier, const int32 Trimmed)
+{
+    // Catches lines that were only trimmed at the start and appended to at the end since the last
+    // calculation, and moves the bezier along instead of recalculating it. The points are checked
+    // against the previous ones, as they may also have been written directly. Returns false if
+    // that isn't what happened, for a regular calculation.
+
+    const int32 NumKept = Bezier.Points.Num() - Trimmed;
+    const int32 NumAppended = Points.Num() - NumKept;
+
+    if ((Trimmed == 0 && NumAppended == 0) || NumKept < 2 || NumAppended < 0 ||
+        Bezier.HardCorners != HardCorners ||
+        Bezier.TangentStrength != TangentStrength ||
+        Bezier.TessellationQuality != TessellationQuality ||
+        !CompareItems(Points.GetData(), Bezier.Points.GetData() + Trimmed, NumKept)) {
+        return false;
+    }
+
+    TessellationSplice = FTessellationSplice();
+    
+    if (Trimmed > 0) {
+        Bezier.Points.TrimFront(Trimmed);
+        if (!Bezier.TrimFront(Trimmed, TessellationSplice)) {
+            // The bezier no longer matches its points, or is due for a full calculation. Emptying
+            // them forces one.
+            Bezier.Points.Reset();
+            return false;
+        }
+    }
+
+    if (NumAppended > 0) {
+        Bezier.Points.Append(Points.GetData() + NumKept, NumAppended);
+        if (!Bezier.AppendRange(NumAppended, TessellationSplice)) {
+            Bezier.Points.Reset();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ALineRenderer::UpdateBounds()
+{
+    // Tells the world's line registry where the line is, so picking can skip lines that are
+    // nowhere near the cursor.
+    
+    ULineRendererSubsystem* Subsystem = GetWorld() ? GetWorld()->GetSubsystem<ULineRendererSubsystem>() : nullptr;
+    if (Subsystem == nullptr) {
+        return;
+    }
+
+    const TLineTrimArray<FVector>& Tessellated = LineMesh->Bezier->Tessellated;
+    const FBox Bounds(Tessellated.GetData(), Tessellated.Num());
+    Subsystem->UpdateLineBounds(this, Bounds.IsValid ? Bounds.ExpandBy(LineWidth) : Bounds);
+}
+
+void ALineRenderer::CreateMesh(const bool FullRebuild)
+{
+    // UE_LOG(LogTemp, Log, TEXT("Create Mesh"));
+
+    // A partial update is only possible when the vertices outside the splice are still valid,
+    // which they aren't if the mesh settings or orientation changed.
+    const bool Incremental = IncrementalTessellation && !FullRebuild && LineMesh->UpVector == EffectiveUpVector;
+    IncrementalTessellation = false;
+    
+    LineMesh->UpVector = EffectiveUpVector; // Also needed for tessellation because orientations are calculated.
+    LineMesh->LineWidth = LineWidth;
+    LineMesh->StartArrow = StartArrow;
+    LineMesh->EndArrow = EndArrow;
+    LineMesh->ArrowScale = ArrowScale;
+
+    if (Incremental) {
+        LineMesh->UpdateMeshRange(TessellationSplice);
+    } else {
+        LineMesh->CreateMesh();
+    }
+}
+
+void ALineRenderer::UpdatePosition()
+{
+    // UE_LOG(LogTemp, Log, TEXT("Position/orientation"));
+
+    LineMesh->UpVector = EffectiveUpVector;
+    LineMesh->UpdatePosition();
+
+    CalculateSideLines();
+    UpdateControlPoints();
+}
+
+void ALineRenderer::UpdateControlPoints()
+{
+    if (ControlPoints != nullptr && Points.Num() == ControlPoints->GetInstanceCount()) {
+        ControlPoints->ControlPointScale = ControlPointScale;
+        ControlPoints->UpdatePositions(Points);
+    }
+}
+
+void ALineRenderer::UpdateMaterials()
+{
+    // UE_LOG(LogTemp, Log, TEXT("Material"));
+
+    LineMesh->LineStyle = LineStyle;
+    LineMesh->ArrowHeadStyle = ArrowHeadStyle;
+    LineMesh->Color1 = LineBodyColor;
+    LineMesh->Color2 = ArrowheadColor;
+    LineMesh->UvDensity = UvDensity;
+    LineMesh->AnimationSpeed = AnimationSpeed;
+    LineMesh->ParametersInPrimitiveData = ParametersInPrimitiveData;
+    LineMesh->UpdateMaterial();
+
+    if (ControlPoints != nullptr) {
+        ControlPoints->ControlPointColor = ControlPointColor;
+        ControlPoints->UpdateMaterial();
+    }
+    
+    UpdateSidelineMaterials();
+}
+
+//
+// ASYNC BUILDS. With AsyncUpdates on, the calculation, mesh and position phases run on a UE::Tasks
+// worker instead of the game thread. The worker gets a copy of the inputs and builds into new
+// beziers and vertex arrays, which are swapped into the meshes on the game thread when it's done.
+// A build launched while another is still running supersedes it.
+//
+
+bool ALineRenderer::UseAsyncBuild() const
+{
+    // Builds are committed by ULineRendererSubsystem, which only ticks in game worlds, and only for
+    // lines registered with it.
+    const UWorld* World = GetWorld();
+    const ULineRendererSubsystem* Subsystem = (World != nullptr && World->IsGameWorld()) ? World->GetSubsystem<ULineRendererSubsystem>() : nullptr;
+    return AsyncUpdates && LineMesh != nullptr && Subsystem != nullptr && Subsystem->IsRegistered(this);
+}
+
+void ALineRenderer::LaunchAsyncBuild(bool Recalculate)
+{
+    if (PendingBuild.IsValid()) {
+        // If the superseded build was going to recalculate the bezier, this one has to.
+        Recalculate = Recalculate || PendingBuild->Recalculate;
+        CancelAsyncBuild();
+    }
+    
+    // The last finished build is reused, along with the meshes it swapped out when committed, so
+    // that steady updates don't allocate. A cancelled build may still be running, so it's not.
+    if (!SpareBuild.IsValid() || !SpareBuild.IsUnique()) {
+        FLineScratchStats::CountAllocation();
+        SpareBuild = MakeShared<FLineBuildJob>();
+    }
+    const TSharedRef<FLineBuildJob> Job = SpareBuild.ToSharedRef();
+    SpareBuild.Reset();
+    
+    Job->Cancelled = false;
+    Job->Recalculate = Recalculate;
+
+    if (Recalculate) {
+        // Builds always calculate the whole bezier.
+        StreamTrimmed = 0;
+
+        if (!Job->Line.Bezier.IsValid() || !Job->Line.Bezier.IsUnique()) {
+            FLineScratchStats::CountAllocation();
+            Job->Line.Bezier = MakeShared<FBezierCalc>();
+        }
+        FLineScratchStats::Reserve(Job->Line.Bezier->Points, Points.Num());
+        Job->Line.Bezier->Points.Reset();
+        Job->Line.Bezier->Points.Append(Points);
+        Job->Line.Bezier->HardCorners = HardCorners;
+        Job->Line.Bezier->TangentStrength = TangentStrength;
+        Job->Line.Bezier->TessellationQuality = TessellationQuality;
+    } else {
+        // Never modified in place while shared, see CalculateLineFundamentals().
+        Job->Line.Bezier = LineMesh->Bezier;
+    }
+
+    FLineMeshBuilder& Geometry = Job->Line.Geometry;
+    Geometry.UpVector = EffectiveUpVector;
+    Geometry.LineWidth = LineWidth;
+    Geometry.StartArrow = StartArrow;
+    Geometry.EndArrow = EndArrow;
+    Geometry.ArrowScale = ArrowScale;
+
+    // Sidelines are only built if they show, which depends on the camera, and if their cached
+    // layout is out of date. Otherwise CommitAsyncBuild() only re-orients or hides them.
+    Job->BuildSideLines = ShowSideLines && SideLinesVisible() && (SideLineLayoutDirty || SideLineMeshes.Num() != SideLines.Num());
+    if (Job->BuildSideLines) {
+        FLineScratchStats::Reserve(Job->SideLines, SideLines.Num());
+        Job->SideLines.Reset();
+        Job->SideLines.Append(SideLines);
+        Job->NumPoints = Points.Num();
+        Job->UpVector = EffectiveUpVector;
+    }
+
+    PendingBuild = Job;
+    PendingTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Job]() {
+        // Cancellation is checked between stages. A cancelled build's results are never used.
+        
+        if (Job->Recalculate) {
+            Job->Line.Bezier->Calculate();
+        }
+
+        if (Job->Cancelled) {
+            return;
+        }
+        Job->Line.Geometry.Build(*Job->Line.Bezier);
+
+        if (Job->Cancelled || !Job->BuildSideLines) {
+            return;
+        }
+        BuildSideLines(*Job->Line.Bezier, Job->SideLines, Job->NumPoints, Job->UpVector, Job->SideLineBuilds);
+    });
+
+    GetWorld()->GetSubsystem<ULineRendererSubsystem>()->AddPendingBuild(this);
+}
+
+bool ALineRenderer::CommitAsyncBuild()
+{
+    // Called by ULineRendererSubsystem on the game thread. Returns false while the build is still
+    // running.
+
+    if (!PendingBuild.IsValid()) {
+        return true;
+    }
+    if (!PendingTask.IsCompleted()) {
+        return false;
+    }
+
+    const TSharedPtr<FLineBuildJob> Job = PendingBuild;
+    PendingBuild.Reset();
+    PendingTask = UE::Tasks::FTask();
+
+    LineMesh->CommitMesh(Job->Line.Bezier, Job->Line.Geometry);
+    UpdateBounds();
+
+    // Kept for the next build. It must not hold on to the line's bezier, which would then have to
+    // be copied before it could be recalculated.
+    if (Job->Line.Bezier == LineMesh->Bezier) {
+        Job->Line.Bezier.Reset();
+    }
+    SpareBuild = Job;
+
+    if (!Job->BuildSideLines) {
+        CalculateSideLines();
+        return true;
+    }
+
+    if (Job->SideLines.Num() == SideLines.Num()) {
+        for (int32 i = 0; i < SideLines.Num(); ++i) {
+            SideLines[i].Side = Job->SideLines[i].Side;
+            SideLines[i].Level = Job->SideLines[i].Level;
+        }
+    }
+
+    CommitSideLines(Job->SideLineBuilds);
+    SideLineLayoutDirty = false;
+    SetSideLineMeshVisibility(true);
+    UpdateSidelineMaterials();
+    return true;
+}
+
+void ALineRenderer::CancelAsyncBuild()
+{
+    // The worker may still be running, but it stops at the next stage and nothing reads its
+    // results.
+    
+    if (PendingBuild.IsValid()) {
+        PendingBuild->Cancelled = true;
+        PendingBuild.Reset();
+        PendingTask = UE::Tasks::FTask();
+    }
+}
+
+//
+// SIDELINES. These are Shot Designer-specific movement arrows that are rendered right next to the
+// main path to illustrate moving a camera back and forth on the same line. Sidelines are always
+// completely calculated during the Position/Orientation update, because orienting them towards the
+// camera involves sloping them differently against the main path depending on view angle.
+//
+
+void ALineRenderer::CalculateSideLines()
+{
+    if (LineMesh == nullptr) {
+        UE_LOG(LogTemp, Log, TEXT("No main line mesh. Cannot draw sidelines"));
+        return;
+    }
+
+    // UE_LOG(LogTemp, Log, TEXT("-------------------------------------------------"));
+
+    if (!ShowSideLines) {
+        SetSideLineMeshQuantity(0);
+        return;
+    }
+
+    // The layout and tessellation of the sidelines only depend on the main line, so they're kept
+    // until it changes. Camera movement only shows or hides them, and re-orients their vertices.
+    // Hidden sidelines keep their meshes.
+
+    const bool Visible = SideLinesVisible();
+    SetSideLineMeshVisibility(Visible);
+    if (!Visible) {
+        return;
+    }
+
+    if (!SideLineLayoutDirty && SideLineMeshes.Num() == SideLines.Num()) {
+        for (ULineMesh* SideLineMesh : SideLineMeshes) {
+            if (SideLineMesh->UpVector != EffectiveUpVector) {
+                SideLineMesh->UpVector = EffectiveUpVector;
+                SideLineMesh->UpdatePosition();
+            }
+        }
+        return;
+    }
+
+    BuildSideLines(*LineMesh->Bezier, SideLines, Points.Num(), EffectiveUpVector, SideLineBuilds);
+    CommitSideLines(SideLineBuilds);
+    SideLineLayoutDirty = false;
+}
+
+void ALineRenderer::SetSideLineMeshVisibility(const bool Visible)
+{
+    for (ULineMesh* SideLineMesh : SideLineMeshes) {
+        if (SideLineMesh->IsVisible() != Visible) {
+            SideLineMesh->SetVisibility(Visible);
+        }
+    }
+}
+
+bool ALineRenderer::SideLinesVisible() const
+{
+    // Sidelines are only meant to be drawn in the camera diagram or when we're looking from above.
+    // Check if the camera is physically over any point on the main bezier (that the angle from a
+    // point up to the camera is close to world up).
+    bool AboveLine = false;
+    for (const FVector& Point: Points) {
+        const float Dot = FVector::DotProduct((CameraLocation - Point).GetSafeNormal(), FVector::UpVector);
+        if (Dot > 0.7) {
+            AboveLine = true;
+            break;
+        }
+    }
+    return ShowSideLines && AboveLine;
+}
+
+void ALineRenderer::BuildSideLines(const FBezierCalc& Bezier, TArray<FSideLine>& InOutSideLines, const int32 NumPoints, const FVector& MeshUpVector, TArray<FLineBuild>& OutBuilds)
+{
+    // Lays out the sidelines along the main bezier, and builds their beziers and meshes. Only
+    // touches its arguments, so it can run on a worker thread. Entries in OutBuilds are reused.
+    // The sidelines follow the main line's tessellation, so nothing on the main bezier is evaluated
+    // again.
+    
+    // Sidelines are always drawn to be seen from above.
+    const FVector SideLineUpVector = FVector(0, 0, 1);
+    
+    FLineScratchStats::Reserve(OutBuilds, InOutSideLines.Num());
+    OutBuilds.SetNum(InOutSideLines.Num(), false);
+
+    // Temporaries live on this thread's FMemStack.
+    FMemMark Mark(FMemStack::Get());
+
+    // Float progress and the standard perpendicular direction at every tessellated point. The
+    // perpendicular points to the left side of the line if looking along the line, like
+    // FBezierCalc::PerpendicularAtPoint(). The direction at a point is taken from its neighbors,
+    // which splits the difference at hard corners.
+
+    const TLineTrimArray<FVector>& Tessellated = Bezier.Tessellated;
+    const int32 NumTessellated = Tessellated.Num();
+    TArray<float, TMemStackAllocator<>> TessFloatProgress;
+    TArray<FVector, TMemStackAllocator<>> TessNormals;
+    TessFloatProgress.SetNumUninitialized(NumTessellated);
+    TessNormals.SetNumUninitialized(NumTessellated);
+
+    int32 Segment = 0;
+    for (int32 i = 0; i < NumTessellated; ++i) {
+        while (Segment + 1 < Bezier.SegmentTessIndexes.Num() && Bezier.SegmentTessIndex(Segment + 1) <= i) {
+            ++Segment;
+        }
+        TessFloatProgress[i] = Segment + Bezier.TessProgress[i];
+        
+        const FVector Direction = Tessellated[FMath::Min(i + 1, NumTessellated - 1)] - Tessellated[FMath::Max(i - 1, 0)];
+        TessNormals[i] = FVector::CrossProduct(Direction, SideLineUpVector).GetSafeNormal();
+    }
+
+    // A point on the tessellated line at a float progress. Positions, normals and progress are
+    // interpolated along the chord the progress falls on.
+
+    struct FSample
+    {
+        FVector Position;
+        FVector Normal;
+        float Progress;
+    };
+
+    auto SampleAt = [&](const float FloatProgress) ->FSample {
+        const int32 Index = FMath::Clamp(Algo::UpperBound(TessFloatProgress, FloatProgress) - 1, 0, NumTessellated - 2);
+        const float Span = TessFloatProgress[Index + 1] - TessFloatProgress[Index];
+        const float Alpha = Span > 0 ? FMath::Clamp((FloatProgress - TessFloatProgress[Index]) / Span, 0.0f, 1.0f) : 0.0f;
+        return {
+            FMath::Lerp(Tessellated[Index], Tessellated[Index + 1], Alpha),
+            FMath::Lerp(TessNormals[Index], TessNormals[Index + 1], Alpha),
+            FMath::Lerp(TessFloatProgress[Index], TessFloatProgress[Index + 1], Alpha)
+        };
+    };
+
+    const bool CanSample = NumTessellated >= 2;
+
+    // Determine sides. Get the dot-product of the perpendicular where the sideline starts and the
+    // notional (assumed) camera angle. If greater than 0, they're pointing towards the same side,
+    // and we need to invert the side in order to try to get sidelines on the opposite sides that
+    // cameras are pointing. Then stack the sidelines on each side.
+
+    for (FSideLine& SideLine : InOutSideLines) {
+        auto [SideLineFrom, SideLineTo] = SideLine.GetFromTo();
+        const FVector StartPerpendicular = CanSample ? SampleAt(SideLineFrom).Normal : FVector::ZeroVector;
+        SideLine.Side = FVector::DotProduct(StartPerpendicular, SideLine.NotionalCameraVector) > 0 ? -1 : 1;
+    }
+
+    LayoutSideLines(InOutSideLines);
+
+    for (int i = 0; i < InOutSideLines.Num(); ++i) {
+        FSideLine& SideLine = InOutSideLines[i];
+        FLineBuild& Build = OutBuilds[i];
+
+        auto [SideLineFrom, SideLineTo] = SideLine.GetFromTo();
+        auto [SideLineStartArrow, SideLineEndArrow] = SideLine.GetArrows();
+
+        // UE_LOG(LogTemp, Log, TEXT("From: %f, To: %f, Side: %d, Level: %d"), SideLineFrom, SideLineTo, SideLine.Side, SideLine.Level);
+
+        // Draw the sideline at the current Side and Level, offset from the tessellated points
+        // between its start and end. Long spans between them are subdivided, in order to ensure
+        // that the sideline reasonably follows the slope of the main line, even if it didn't start
+        // and end where the main line did and doesn't have the same tangents. The points go
+        // straight into the sideline's bezier, which keeps its allocation between builds. Points
+        // that are too close to the previous point are discarded, in order to prevent folding in
+        // sharp corners.
+
+        if (!Build.Bezier.IsValid()) {
+            FLineScratchStats::CountAllocation();
+            Build.Bezier = MakeShared<FBezierCalc>();
+        }
+        FBezierCalc& SideLineBezier = *Build.Bezier;
+        TLineTrimArray<FVector>& FinalPoints = SideLineBezier.Points;
+        FinalPoints.Reset();
+
+        if (CanSample) {
+            const float SnapFrom = FMath::Clamp(FMathUtil::SnapToWholeNumber(SideLineFrom, 0.02f), 0, NumPoints);
+            const float SnapTo = FMath::Clamp(FMathUtil::SnapToWholeNumber(SideLineTo, 0.02f), 0, NumPoints);
+            const int32 FirstInside = Algo::UpperBound(TessFloatProgress, SnapFrom);
+            const int32 EndInside = Algo::LowerBound(TessFloatProgress, SnapTo);
+            FLineScratchStats::Reserve(FinalPoints, FMath::Max(EndInside - FirstInside, 0) + 2);
+
+            constexpr float MaxSpan = 0.1;
+            constexpr float Avoidance = 4; // Points can't be closer than this.
+            const float Offset = SideLine.Side * (20 + 15 * SideLine.Level);
+
+            auto AddPoint = [&](const FVector& Position, const FVector& Normal) {
+                const FVector Point = Position + Normal.GetSafeNormal() * Offset;
+                if (FinalPoints.Num() > 0 && (Point - FinalPoints.Last()).Size() < Avoidance) {
+                    return;
+                }
+                FinalPoints.Add(Point);
+            };
+
+            // Consecutive samples are always on the same chord, so subdividing between them stays
+            // on the tessellated line.
+            FSample Previous = SampleAt(SnapFrom);
+            AddPoint(Previous.Position, Previous.Normal);
+
+            auto AddSample = [&](const FSample& Next) {
+                const float Span = Next.Progress - Previous.Progress;
+                if (Span > MaxSpan) {
+                    const int32 NumSubdivisions = static_cast<int32>(Span / MaxSpan);
+                    for (int32 t = 1; t <= NumSubdivisions; ++t) {
+                        const float Alpha = static_cast<float>(t) / (NumSubdivisions + 1);
+                        AddPoint(FMath::Lerp(Previous.Position, Next.Position, Alpha), FMath::Lerp(Previous.Normal, Next.Normal, Alpha));
+                    }
+                }
+                AddPoint(Next.Position, Next.Normal);
+                Previous = Next;
+            };
+
+            for (int32 j = FirstInside; j < EndInside; ++j) {
+                AddSample({ Tessellated[j], TessNormals[j], TessFloatProgress[j] });
+            }
+            AddSample(SampleAt(SnapTo));
+        }
+        
+        // for (const auto& Point: FinalPoints) {
+        //     UE_LOG(LogTemp, Log, TEXT("Point: %f,%f,%f"), Point.X, Point.Y, Point.Z);
+        // }
+
+        SideLineBezier.TessellationQuality = 0.98;
+        SideLineBezier.HardCorners = false;
+
+        FLineMeshBuilder& Geometry = Build.Geometry;
+        Geometry.LineWidth = 1.5;
+        Geometry.ArrowScale = 1;
+        Geometry.UpVector = MeshUpVector;
+        Geometry.StartArrow = SideLineStartArrow;
+        Geometry.EndArrow = SideLineEndArrow;
+        
+        SideLineBezier.Calculate();
+        Geometry.Build(SideLineBezier);
+    }
+}
+
+void ALineRenderer::LayoutSideLines(TArray<FSideLine>& InOutSideLines)
+{
+    // Picks a level for every sideline, so that sidelines on the same side whose ranges overlap
+    // are stacked on different levels. Per side, the sidelines are swept in order of where they
+    // start, and each takes the lowest level that no sideline still running is on. That is the
+    // fewest levels possible, in O(n log n). Ranges closer than Margin count as overlapping.
+
+    constexpr float Margin = 0.05;
+
+    FMemMark Mark(FMemStack::Get());
+
+    struct FSpan
+    {
+        int32 Side;
+        float From;
+        float End; // Including the margin.
+        int32 Index;
+    };
+
+    struct FRunning
+    {
+        float End;
+        int32 Level;
+    };
+
+    TArray<FSpan, TMemStackAllocator<>> Spans;
+    Spans.Reserve(InOutSideLines.Num());
+    for (int32 i = 0; i < InOutSideLines.Num(); ++i) {
+        auto [SideLineFrom, SideLineTo] = InOutSideLines[i].GetFromTo();
+        Spans.Add({ InOutSideLines[i].Side, SideLineFrom, SideLineTo + Margin, i });
+    }
+
+    Algo::Sort(Spans, [](const FSpan& A, const FSpan& B) {
+        if (A.Side != B.Side) {
+            return A.Side < B.Side;
+        }
+        if (A.From != B.From) {
+            return A.From < B.From;
+        }
+        return A.Index < B.Index;
+    });
+
+    // Sidelines still running, soonest ending first, and levels that were freed up, lowest first.
+    TArray<FRunning, TMemStackAllocator<>> Running;
+    TArray<int32, TMemStackAllocator<>> FreeLevels;
+    const auto EndsFirst = [](const FRunning& A, const FRunning& B) { return A.End < B.End; };
+    int32 NextLevel = 0;
+
+    for (int32 i = 0; i < Spans.Num(); ++i) {
+        const FSpan& Span = Spans[i];
+
+        if (i > 0 && Span.Side != Spans[i - 1].Side) {
+            Running.Reset();
+            FreeLevels.Reset();
+            NextLevel = 0;
+        }
+
+        while (Running.Num() > 0 && Running.HeapTop().End <= Span.From) {
+            FRunning Ended;
+            Running.HeapPop(Ended, EndsFirst, false);
+            FreeLevels.HeapPush(Ended.Level);
+        }
+
+        int32 Level;
+        if (FreeLevels.Num() > 0) {
+            FreeLevels.HeapPop(Level, false);
+        } else {
+            Level = NextLevel++;
+        }
+
+        Running.HeapPush({ Span.End, Level }, EndsFirst);
+        InOutSideLines[Span.Index].Level = Level;
+    }
+}
+
+void ALineRenderer::CommitSideLines(TArray<FLineBuild>& Builds)
+{
+    // Hands the built sidelines to their meshes. The meshes' previous beziers and vertices are
+    // swapped into Builds, to be reused next time.
+    
+    SetSideLineMeshQuantity(Builds.Num());
+
+    for (int32 i = 0; i < Builds.Num(); ++i) {
+        ULineMesh* SideLineMesh = SideLineMeshes[i];
+        SideLineMesh->AutoInit();
+        SideLineMesh->CommitMesh(Builds[i].Bezier, Builds[i].Geometry);
+    }
+}
+
+void ALineRenderer::UpdateSidelineMaterials()
+{
+    for (const auto& SideLineMesh: SideLineMeshes) {
+        SideLineMesh->Color1 = FLinearColor(0, 0, 0, 1);
+        SideLineMesh->ParametersInPrimitiveData = ParametersInPrimitiveData;
+        SideLineMesh->UpdateMaterial();
+    }
+}
+
+std::tuple<float, float> FSideLine::GetFromTo() const
+{
+    // Observe that this is a method in FSideLine.
+    if (FromFloatProgress <= ToFloatProgress) {
+        return std::make_tuple(FromFloatProgress, ToFloatProgress);
+    } else {
+        return std::make_tuple(ToFloatProgress, FromFloatProgress);
+    }
+}
+
+std::tuple<bool, bool> FSideLine::GetArrows() const
+{
+    // Observe that this is a method in FSideLine.
+    if (FromFloatProgress <= ToFloatProgress) {
+        return std::make_tuple(StartArrow, EndArrow);
+    } else {
+        return std::make_tuple(EndArrow, StartArrow);
+    }
+}
+
+//
+// BATCHED UPDATES
+//
+
+void ALineRenderer::BeginUpdate()
+{
+    ++UpdateDepth;
+}
+
+void ALineRenderer::EndUpdate()
+{
+    if (UpdateDepth == 0) {
+        UE_LOG(LogTemp, Warning, TEXT("EndUpdate() without BeginUpdate() on %s"), *GetName());
+        return;
+    }
+
+    // Properties may have been written directly in the batch, so the pass fingerprints them.
+    if (--UpdateDepth == 0) {
+        PendingFingerprintCheck = true;
+        RequestUpdate();
+    }
+}
+
+void ALineRenderer::FlushUpdates()
+{
+    UpdatePending = false;
+    
+    if (DirtyPhase == EPhases::End && !PendingFingerprintCheck) {
+        return;
+    }
+
+    const bool CheckFingerprints = PendingFingerprintCheck;
+    PendingFingerprintCheck = false;
+    ChangeDetection(false, CheckFingerprints);
+}
+
+FLineRendererUpdateScope::FLineRendererUpdateScope(ALineRenderer* InLine)
+    : Line(InLine)
+{
+    if (Line != nullptr) {
+        Line->BeginUpdate();
+    }
+}
+
+FLineRendererUpdateScope::~FLineRendererUpdateScope()
+{
+    if (Line != nullptr) {
+        Line->EndUpdate();
+    }
+}
+
+//
+// STREAMING
+//
+
+void ALineRenderer::AppendPoints(const TArray<FVector>& NewPoints)
+{
+    Points.Append(NewPoints);
+    if (MaxPoints > 0 && Points.Num() > MaxPoints) {
+        RemoveFrontPoints(Points.Num() - MaxPoints);
+    }
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, Points));
+}
+
+void ALineRenderer::AppendPoint(const FVector& NewPoint)
+{
+    Points.Add(NewPoint);
+    if (MaxPoints > 0 && Points.Num() > MaxPoints) {
+        RemoveFrontPoints(Points.Num() - MaxPoints);
+    }
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, Points));
+}
+
+void ALineRenderer::TrimPoints(const int32 Count)
+{
+    RemoveFrontPoints(Count);
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, Points));
+}
+
+void ALineRenderer::RemoveFrontPoints(int32 Count)
+{
+    // Counts the trimmed points, so that the next calculation can drop the same number from the
+    // bezier. Sideline positions are in points, so they are moved back with them. Sidelines that
+    // were entirely on the trimmed points are removed, and ones that were partly on them are cut
+    // off at the new start.
+    
+    Count = FMath::Min(Count, Points.Num());
+    if (Count <= 0) {
+        return;
+    }
+
+    Points.RemoveAt(0, Count, false);
+    StreamTrimmed += Count;
+
+    SideLines.RemoveAll([Count](const FSideLine& SideLine) {
+        auto [SideLineFrom, SideLineTo] = SideLine.GetFromTo();
+        return SideLineTo - Count <= 0;
+    });
+
+    for (FSideLine& SideLine : SideLines) {
+        SideLine.FromFloatProgress = FMath::Max(SideLine.FromFloatProgress - Count, 0.0f);
+        SideLine.ToFloatProgress = FMath::Max(SideLine.ToFloatProgress - Count, 0.0f);
+    }
+}
+
+//
+// SETTERS
+//
+
+void ALineRenderer::SetPoints(const TArray<FVector>& InPoints)
+{
+    Points = InPoints;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, Points));
+}
+
+void ALineRenderer::SetPoint(const int32 Index, const FVector& InPoint)
+{
+    if (!Points.IsValidIndex(Index)) {
+        return;
+    }
+    Points[Index] = InPoint;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, Points));
+}
+
+void ALineRenderer::SetHardCorners(const bool InHardCorners)
+{
+    HardCorners = InHardCorners;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, HardCorners));
+}
+
+void ALineRenderer::SetLineWidth(const float InLineWidth)
+{
+    LineWidth = InLineWidth;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, LineWidth));
+}
+
+void ALineRenderer::SetTessellationQuality(const float InTessellationQuality)
+{
+    TessellationQuality = InTessellationQuality;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, TessellationQuality));
+}
+
+void ALineRenderer::SetTangentStrength(const float InTangentStrength)
+{
+    TangentStrength = InTangentStrength;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, TangentStrength));
+}
+
+void ALineRenderer::SetLineBodyColor(const FLinearColor& InLineBodyColor)
+{
+    LineBodyColor = InLineBodyColor;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, LineBodyColor));
+}
+
+void ALineRenderer::SetLineStyle(const ELineRendererStyle InLineStyle)
+{
+    LineStyle = InLineStyle;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, LineStyle));
+}
+
+void ALineRenderer::SetArrowHeadStyle(const ELineRendererStyle InArrowHeadStyle)
+{
+    ArrowHeadStyle = InArrowHeadStyle;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, ArrowHeadStyle));
+}
+
+void ALineRenderer::SetUvDensity(const float InUvDensity)
+{
+    UvDensity = InUvDensity;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, UvDensity));
+}
+
+void ALineRenderer::SetAnimationSpeed(const float InAnimationSpeed)
+{
+    AnimationSpeed = InAnimationSpeed;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, AnimationSpeed));
+}
+
+void ALineRenderer::SetParametersInPrimitiveData(const bool InParametersInPrimitiveData)
+{
+    ParametersInPrimitiveData = InParametersInPrimitiveData;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, ParametersInPrimitiveData));
+}
+
+void ALineRenderer::SetStartArrow(const bool InStartArrow)
+{
+    StartArrow = InStartArrow;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, StartArrow));
+}
+
+void ALineRenderer::SetEndArrow(const bool InEndArrow)
+{
+    EndArrow = InEndArrow;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, EndArrow));
+}
+
+void ALineRenderer::SetArrowheadColor(const FLinearColor& InArrowheadColor)
+{
+    ArrowheadColor = InArrowheadColor;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, ArrowheadColor));
+}
+
+void ALineRenderer::SetArrowScale(const float InArrowScale)
+{
+    ArrowScale = InArrowScale;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, ArrowScale));
+}
+
+void ALineRenderer::SetShowControlPoints(const bool InShowControlPoints)
+{
+    ShowControlPoints = InShowControlPoints;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, ShowControlPoints));
+}
+
+void ALineRenderer::SetControlPointColor(const FLinearColor& InControlPointColor)
+{
+    ControlPointColor = InControlPointColor;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, ControlPointColor));
+}
+
+void ALineRenderer::SetControlPointScale(const float InControlPointScale)
+{
+    ControlPointScale = InControlPointScale;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, ControlPointScale));
+}
+
+void ALineRenderer::SetShowSideLines(const bool InShowSideLines)
+{
+    ShowSideLines = InShowSideLines;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, ShowSideLines));
+}
+
+void ALineRenderer::SetSideLines(const TArray<FSideLine>& InSideLines)
+{
+    SideLines = InSideLines;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, SideLines));
+}
+
+void ALineRenderer::SetSideLineColor(const FLinearColor& InSideLineColor)
+{
+    SideLineColor = InSideLineColor;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, SideLineColor));
+}
+
+void ALineRenderer::SetCameraFacing(const bool InCameraFacing)
+{
+    CameraFacing = InCameraFacing;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, CameraFacing));
+}
+
+void ALineRenderer::SetUpVector(const FVector& InUpVector)
+{
+    UpVector = InUpVector;
+    PropertyChanged(GET_MEMBER_NAME_CHECKED(ALineRenderer, UpVector));
+}
+
+//
+// FORWARDERS
+//
+
+FVector ALineRenderer::CalculateLinearPoint(const float Progress) const
+{
+    // Forwarder to get linear position on bezier. Suitable for animation, because speed will be
+    // constant even with segments of varying lengths. Remember to call ChangeDetection() first.
+    
+    if (LineMesh != nullptr && LineMesh->Bezier.IsValid()) {
+        return LineMesh->Bezier->CalculateLinearPoint(Progress);
+    } else {
+        return FVector::ZeroVector;
+    }
+}
+
+FVector ALineRenderer::SlopeAtLinearPoint(const float Progress) const
+{
+    // Forwarder to get the direction of travel at a linear position on the bezier. Matches the
+    // movement of CalculateLinearPoint(). Remember to call ChangeDetection() first.
+    
+    if (LineMesh != nullptr && LineMesh->Bezier.IsValid()) {
+        return LineMesh->Bezier->SlopeAtLinearPoint(Progress);
+    } else {
+        return FVector::ZeroVector;
+    }
+}
+
+float ALineRenderer::DistanceAtFloatProgress(const float FloatProgress) const
+{
+    // Forwarder to convert segment + progress (e.g. 1.7) to distance along the line. Remember to
+    // call ChangeDetection() first.
+    
+    if (LineMesh != nullptr && LineMesh->Bezier.IsValid()) {
+        return LineMesh->Bezier->DistanceAtFloatProgress(FloatProgress);
+    } else {
+        return 0;
+    }
+}
+
+float ALineRenderer::FloatProgressAtDistance(const float Distance) const
+{
+    // Forwarder to convert distance along the line to segment + progress (e.g. 1.7). Remember to
+    // call ChangeDetection() first.
+    
+    if (LineMesh != nullptr && LineMesh->Bezier.IsValid()) {
+        return LineMesh->Bezier->FloatProgressAtDistance(Distance);
+    } else {
+        return 0;
+    }
+}
+
+FVector ALineRenderer::CalculateBezierPoint(const float Progress) const
+{
+    // Forwarder to get position on bezier based purely on segment + progress (e.g. Progress 1.7 for
+    // Segment 1 Progress 0.7). Not suitable for animation, as it doesn't compensate for segments of
+    // different lengths. Remember to call ChangeDetection() first.
+    
+    if (LineMesh != nullptr && LineMesh->Bezier.IsValid()) {
+        return LineMesh->Bezier->CalculateBezierPoint(Progress);
+    } else {
+        return FVector::ZeroVector;
+    }
+}
+
+FVector ALineRenderer::CalculateBezierPoint(const int32 Segment, const float Progress) const
+{
+    // Forwarder to get position on bezier based purely on segment and progress as separate values.
+    // Not suitable for animation, as it doesn't compensate for segments of different lengths.
+    // Remember to call ChangeDetection() first.
+    
+    if (LineMesh != nullptr && LineMesh->Bezier.IsValid()) {
+        return LineMesh->Bezier->CalculateBezierPoint(Segment, Progress);
+    } else {
+        return FVector::ZeroVector;
+    }
+}
+
+FBezierFrame ALineRenderer::EvaluateFrame(const float FloatProgress) const
+{
+    // Forwarder to get position, direction, normal and curvature at a segment + progress (e.g.
+    // 1.7). The normal is perpendicular to the line's current up vector, so it lies in the plane of
+    // the rendered line. Remember to call ChangeDetection() first.
+    
+    if (LineMesh != nullptr && LineMesh->Bezier.IsValid()) {
+        return LineMesh->Bezier->EvaluateFrame(FloatProgress, EffectiveUpVector);
+    } else {
+        return FBezierFrame{};
+    }
+}
+
+FBezierNearestResult ALineRenderer::FindNearestPoint(const FVector& Point) const
+{
+    // Forwarder to find the closest point on the line to a point in world space. Remember to call
+    // ChangeDetection() first.
+    
+    if (LineMesh != nullptr && LineMesh->Bezier.IsValid()) {
+        return LineMesh->Bezier->FindNearestPoint(Point);
+    } else {
+        return FBezierNearestResult{};
+    }
+}
+
+FBezierNearestResult ALineRenderer::FindNearestToRay(const FVector& Origin, const FVector& Direction) const
+{
+    // Forwarder to find the closest point on the line to a ray in world space. Remember to call
+    // ChangeDetection() first.
+    
+    if (LineMesh != nullptr && LineMesh->Bezier.IsValid()) {
+        return LineMesh->Bezier->FindNearestToRay(Origin, Direction);
+    } else {
+        return FBezierNearestResult{};
+    }
+}
+
+FHitDetectionResult ALineRenderer::HitDetectPoints(FLineHitQueryContext& Context, const FVector2D& HitPos, const float MaxDistance) const
+{
+    if (LineMesh != nullptr && LineMesh->Bezier.IsValid()) {
+        return LineMesh->Bezier->HitDetectPoints(Context, HitPos, MaxDistance);
+    } else {
+        return FHitDetectionResult{};
+    }
+}
+
+FHitDetectionResult ALineRenderer::HitDetectPoints(const APlayerController* Player, const FVector2D& HitPos, const float MaxDistance) const
+{
+    // Convenience for a single query. When testing many lines, build one FLineHitQueryContext and
+    // pass it to all of them instead.
+    
+    FLineHitQueryContext Context;
+    if (!Context.Init(Player)) {
+        return FHitDetectionResult{};
+    }
+    return HitDetectPoints(Context, HitPos, MaxDistance);
+}
+
+FHitDetectionResult ALineRenderer::HitDetectSpline(FLineHitQueryContext& Context, const FVector2D& HitPos, const float MaxDistance) const
+{
+    if (LineMesh != nullptr && LineMesh->Bezier.IsValid()) {
+        return LineMesh->Bezier->HitDetectSpline(Context, HitPos, MaxDistance);
+    } else {
+        return FHitDetectionResult{};
+    }
+}
+
+FHitDetectionResult ALineRenderer::HitDetectSpline(const APlayerController* Player, const FVector2D& HitPos, const float MaxDistance) const
+{
+    // Convenience for a single query. When testing many lines, build one FLineHitQueryContext and
+    // pass it to all of them instead.
+    
+    FLineHitQueryContext Context;
+    if (!Context.Init(Player)) {
+        return FHitDetectionResult{};
+    }
+    return HitDetectSpline(Context, HitPos, MaxDistance);
+}
+
+//
+// UTILITY
+//
+
+void ALineRenderer::ResetDebugLines() const
+{
+    FlushPersistentDebugLines(GetWorld());
+}
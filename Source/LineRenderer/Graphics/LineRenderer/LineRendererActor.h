@@ -1,217 +1,408 @@
-﻿// Copyright Hollywood Camera Work
-
-#pragma once
-
-#include <tuple>
-
-#include "CoreMinimal.h"
-#include "GameFramework/Actor.h"
-
-#include "LineRendererIncludes.h"
-#include "LineRendererActor.generated.h"
-
-class FBezierCalc;
-class ULineMesh;
-class ULineControlPoint;
-
-// STRUCTS
-
-USTRUCT(BlueprintType)
-struct FSideLine
-{
-    GENERATED_BODY()
-
-    // These From/To/Start/End properties should ideally be private, but that precludes them being
-    // edited in blueprint. Don't read these raw values, as the logic doesn't support inverted
-    // lines. Instead, use GetFromTo() and GetArrows(), which order them correctly.
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite)
-    float FromFloatProgress = 0.25;
-
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite)
-    float ToFloatProgress = 0.75;
-
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite)
-    bool StartArrow = false;
-
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite)
-    bool EndArrow = false;
-
-    // KeepClearVector represents the direction a camera would point at the very start. Causes the
-    // sidelines to prefer to be rendered on the opposite side of the line.
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite)
-    FVector NotionalCameraVector = FVector(0, 1, 0);
-
-    // Additional unsaved properties. Must be initialized on every usage.
-    // TArray<float> ProgressPoints;
-    // bool EffectiveStartArrow = false;
-    // bool EffectiveEndArrow = false;
-    public: int32 Side = 1;
-    public: int32 Level = 0;
-
-    public: std::tuple<float, float> GetFromTo() const;
-    public: std::tuple<bool, bool> GetArrows() const;
-};
-
-UCLASS()
-class LINERENDERER_API ALineRenderer : public AActor
-{
-    GENERATED_BODY()
-
-    // ENUMS
-    
-    enum class EPhases {
-        Start,
-        Calculation,
-        CreateMesh,
-        Position,
-        Material,
-        End,
-    };
-
-    enum class ELineElements {
-        MainLine,
-        StartArrow,
-        EndArrow,
-        SideLines,
-        TheEnd, // Used to get number of enums
-    };
-
-    // METHODS
-    
-    public: ALineRenderer();
-    
-    protected: virtual void BeginPlay() override;
-    private: void Init();
-
-    public: virtual void Tick(const float DeltaTime) override;
-    
-#if WITH_EDITOR
-    public: virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
-    public: virtual void PostLoad() override;
-#endif
-
-    // FORWARDERS
-    
-    public: FVector CalculateLinearPoint(float Progress) const;
-    public: FVector CalculateBezierPoint(float Progress) const;
-    public: FVector CalculateBezierPoint(int32 Segment, float Progress) const;
-    public: FHitDetectionResult HitDetectPoints(const APlayerController* Player, const FVector2D& HitPos) const;
-    public: FHitDetectionResult HitDetectSpline(const APlayerController* Player, const FVector2D& HitPos) const;
-
-    // INTERNAL METHODS
-    
-    private: void CreateLineMesh(const bool ShouldExist);
-    private: void SetSideLineMeshQuantity(int32 Desired);
-    private: void SetControlPointQuantity(int32 Desired);
-    private: void ChangeDetection(const bool Force = false);
-    private: void CalculateLineFundamentals() const;
-    private: void CreateMesh() const;
-    private: void UpdatePosition();
-    private: void UpdateMaterials();
-    private: void CalculateSideLines();
-    private: void UpdateSidelineMaterials();
-    private: void ResetDebugLines() const;
-
-    // PUBLIC UPROPERTIES
-
-    // Bezier Section
-    
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Bezier")
-    TArray<FVector> Points;
-
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Bezier")
-    bool HardCorners = true;
-
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Bezier")
-    float LineWidth = 10;
-
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Bezier", meta=(EditCondition="!HardCorners", ClampMin = "0.5", ClampMax = "0.99"))
-    float TessellationQuality = 0.95;
-
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Bezier", meta=(EditCondition="!HardCorners"))
-    float TangentStrength = 0.3; // In fraction of a segment. Must not be greater than 0.5.
-
-    // Appearance Section
-    
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Main Appearance")
-    FLinearColor LineBodyColor = FLinearColor(0, 0.03, 0.6, 1);
-    
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Main Appearance")
-    ELineRendererStyle LineStyle = ELineRendererStyle::SolidColor;
-
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Main Appearance")
-    ELineRendererStyle ArrowHeadStyle = ELineRendererStyle::SolidColor;
-
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Main Appearance")
-    float UvDensity = 1;
-
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Main Appearance")
-    float AnimationSpeed = 1;
-
-    // Arrow Heads
-
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Arrowhead Appearance")
-    bool StartArrow = false;
-
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Arrowhead Appearance")
-    bool EndArrow = false;
-
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Arrowhead Appearance")
-    FLinearColor ArrowheadColor = FLinearColor(0, 0.24, 0.54, 1);
-    
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Arrowhead Appearance", meta=(EditCondition="StartArrow || EndArrow"))
-    float ArrowScale = 1;
-
-    // Control points
-
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Control Point Appearance")
-    bool ShowControlPoints = true;
-
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Control Point Appearance", meta=(EditCondition="ShowControlPoints"))
-    FLinearColor ControlPointColor = FLinearColor(0, 0, 0, 1);
-    
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Control Point Appearance", meta=(EditCondition="ShowControlPoints"))
-    float ControlPointScale = 1;
-
-    // Sidelines Section
-
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Sidelines")
-    bool ShowSideLines = true;
-
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Sidelines")
-    TArray<FSideLine> SideLines;
-    
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Sidelines")
-    FLinearColor SideLineColor;
-    
-    // Orientation Section
-    
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Orientation")
-    bool CameraFacing = false;
-    
-    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Orientation", meta=(EditCondition="!CameraFacing"))
-    FVector UpVector = FVector(0, 0, 1);
-
-    // PRIVATE UPROPERTIES
-
-    public: UPROPERTY()
-    ULineMesh* LineMesh;
-
-    public: UPROPERTY()
-    TArray<ULineMesh*> SideLineMeshes;
-
-    public: UPROPERTY()
-    TArray<ULineControlPoint*> ControlPoints;
-
-    // PRIVATE PROPERTIES
-    
-    private: TArray<uint8> LineFingerprint;
-    private: TArray<uint8> TessellationFingerprint;
-    private: TArray<uint8> PositionFingerprint;
-    private: TArray<uint8> MaterialFingerprint;
-    private: FVector CameraForward = FVector(0, 0, -1);
-    private: FVector OldCameraForward = FVector(0, 0, -1);
-    private: FVector CameraLocation = FVector(0, 0, 1);
-    private: FVector OldCameraLocation = FVector(0, 0, 1);
-    private: FVector EffectiveUpVector = FVector(0, 0, 1);
-};
+﻿// Copyright Hollywood Camera Work
+
+#pragma once
+
+#include <tuple>
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Tasks/Task.h"
+
+#include "LineRendererIncludes.h"
+#include "BezierCalc.h"
+#include "LineMeshBuilder.h"
+#include "LineRendererActor.generated.h"
+
+class ULineMesh;
+class ULineControlPoints;
+class FLineHitQueryContext;
+struct FLineBuildJob;
+
+// STRUCTS
+
+USTRUCT(BlueprintType)
+struct FSideLine
+{
+    GENERATED_BODY()
+
+    // These From/To/Start/End properties should ideally be private, but that precludes them being
+    // edited in blueprint. Don't read these raw values, as the logic doesn't support inverted
+    // lines. Instead, use GetFromTo() and GetArrows(), which order them correctly.
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    float FromFloatProgress = 0.25;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    float ToFloatProgress = 0.75;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    bool StartArrow = false;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    bool EndArrow = false;
+
+    // KeepClearVector represents the direction a camera would point at the very start. Causes the
+    // sidelines to prefer to be rendered on the opposite side of the line.
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    FVector NotionalCameraVector = FVector(0, 1, 0);
+
+    // Additional unsaved properties. Must be initialized on every usage.
+    // TArray<float> ProgressPoints;
+    // bool EffectiveStartArrow = false;
+    // bool EffectiveEndArrow = false;
+    public: int32 Side = 1;
+    public: int32 Level = 0;
+
+    public: std::tuple<float, float> GetFromTo() const;
+    public: std::tuple<bool, bool> GetArrows() const;
+};
+
+UCLASS()
+class LINERENDERER_API ALineRenderer : public AActor
+{
+    GENERATED_BODY()
+
+    // ENUMS
+    
+    enum class EPhases {
+        Start,
+        Calculation,
+        CreateMesh,
+        Position,
+        Material,
+        End,
+    };
+
+    enum class ELineElements {
+        MainLine,
+        StartArrow,
+        EndArrow,
+        SideLines,
+        TheEnd, // Used to get number of enums
+    };
+
+    // METHODS
+    
+    public: ALineRenderer();
+    
+    protected: virtual void BeginPlay() override;
+    protected: virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+    private: void Init();
+
+    public: virtual void Tick(const float DeltaTime) override;
+    public: bool NeedsCameraUpdate(const FVector& Location, const FVector& Forward) const;
+    public: float OrientationError(const FVector& Location, const FVector& Forward, const float Distance) const;
+    public: void UpdateCamera(const FVector& Location, const FVector& Forward);
+    public: bool CommitAsyncBuild();
+    
+#if WITH_EDITOR
+    public: virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+    public: virtual void PostLoad() override;
+#endif
+
+    // FORWARDERS
+    
+    public: FVector CalculateLinearPoint(float Progress) const;
+    public: FVector SlopeAtLinearPoint(float Progress) const;
+    public: float DistanceAtFloatProgress(float FloatProgress) const;
+    public: float FloatProgressAtDistance(float Distance) const;
+    public: FVector CalculateBezierPoint(float Progress) const;
+    public: FVector CalculateBezierPoint(int32 Segment, float Progress) const;
+    public: FBezierFrame EvaluateFrame(float FloatProgress) const;
+    public: FBezierNearestResult FindNearestPoint(const FVector& Point) const;
+    public: FBezierNearestResult FindNearestToRay(const FVector& Origin, const FVector& Direction) const;
+    public: FHitDetectionResult HitDetectPoints(FLineHitQueryContext& Context, const FVector2D& HitPos, float MaxDistance = std::numeric_limits<float>::max()) const;
+    public: FHitDetectionResult HitDetectPoints(const APlayerController* Player, const FVector2D& HitPos, float MaxDistance = std::numeric_limits<float>::max()) const;
+    public: FHitDetectionResult HitDetectSpline(FLineHitQueryContext& Context, const FVector2D& HitPos, float MaxDistance = std::numeric_limits<float>::max()) const;
+    public: FHitDetectionResult HitDetectSpline(const APlayerController* Player, const FVector2D& HitPos, float MaxDistance = std::numeric_limits<float>::max()) const;
+
+    // BATCHED UPDATES. Changes made between BeginUpdate() and EndUpdate(), through setters or by
+    // writing properties directly, are applied in one pass. In game worlds that pass runs at the
+    // end of the frame. FlushUpdates() runs it right away, e.g. before reading back the bezier.
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Updates")
+    void BeginUpdate();
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Updates")
+    void EndUpdate();
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Updates")
+    void FlushUpdates();
+
+    // STREAMING. For lines that grow at one end and shrink at the other, like trails. Only the
+    // segments at the ends are recalculated and sent, however long the line is. Trimmed points are
+    // left behind the front of the tessellation and the mesh, and reclaimed once in a while, so
+    // the rest of the line isn't moved on every trim. Sidelines move back with the points they're
+    // on when points are trimmed, and are removed when all of them are.
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Bezier")
+    void AppendPoints(const TArray<FVector>& NewPoints);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Bezier")
+    void AppendPoint(const FVector& NewPoint);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Bezier")
+    void TrimPoints(const int32 Count);
+
+    // SETTERS. Setting properties through these tells change detection exactly what changed, so
+    // nothing needs to be fingerprinted. Outside of BeginUpdate()/EndUpdate(), changes made in the
+    // same frame are still applied together. Properties written directly, without a setter or a
+    // batch, are only picked up by the next fingerprinted pass, which for camera facing lines is
+    // the next camera move.
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Bezier")
+    void SetPoints(const TArray<FVector>& InPoints);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Bezier")
+    void SetPoint(const int32 Index, const FVector& InPoint);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Bezier")
+    void SetHardCorners(const bool InHardCorners);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Bezier")
+    void SetLineWidth(const float InLineWidth);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Bezier")
+    void SetTessellationQuality(const float InTessellationQuality);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Bezier")
+    void SetTangentStrength(const float InTangentStrength);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Main Appearance")
+    void SetLineBodyColor(const FLinearColor& InLineBodyColor);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Main Appearance")
+    void SetLineStyle(const ELineRendererStyle InLineStyle);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Main Appearance")
+    void SetArrowHeadStyle(const ELineRendererStyle InArrowHeadStyle);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Main Appearance")
+    void SetUvDensity(const float InUvDensity);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Main Appearance")
+    void SetAnimationSpeed(const float InAnimationSpeed);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Main Appearance")
+    void SetParametersInPrimitiveData(const bool InParametersInPrimitiveData);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Arrowhead Appearance")
+    void SetStartArrow(const bool InStartArrow);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Arrowhead Appearance")
+    void SetEndArrow(const bool InEndArrow);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Arrowhead Appearance")
+    void SetArrowheadColor(const FLinearColor& InArrowheadColor);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Arrowhead Appearance")
+    void SetArrowScale(const float InArrowScale);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Control Point Appearance")
+    void SetShowControlPoints(const bool InShowControlPoints);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Control Point Appearance")
+    void SetControlPointColor(const FLinearColor& InControlPointColor);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Control Point Appearance")
+    void SetControlPointScale(const float InControlPointScale);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Sidelines")
+    void SetShowSideLines(const bool InShowSideLines);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Sidelines")
+    void SetSideLines(const TArray<FSideLine>& InSideLines);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Sidelines")
+    void SetSideLineColor(const FLinearColor& InSideLineColor);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Orientation")
+    void SetCameraFacing(const bool InCameraFacing);
+
+    public: UFUNCTION(BlueprintCallable, Category="Line Renderer|Orientation")
+    void SetUpVector(const FVector& InUpVector);
+
+    // INTERNAL METHODS
+    
+    private: void CreateLineMesh(const bool ShouldExist);
+    private: void SetSideLineMeshQuantity(int32 Desired);
+    private: void SetControlPointQuantity(int32 Desired);
+    private: void ChangeDetection(const bool Force = false, const bool CheckFingerprints = true);
+    private: void PropertyChanged(const FName PropertyName);
+    private: void RemoveFrontPoints(int32 Count);
+    private: void RequestUpdate();
+    private: void MarkDirty(const EPhases Phase);
+    private: static bool PhaseForProperty(const FName PropertyName, EPhases& OutPhase);
+    private: uint64 SideLineInputFingerprint() const;
+    private: bool BezierInputsChanged() const;
+    private: void CalculateLineFundamentals(const bool AllowIncremental);
+    private: bool CalculateStreamed(FBezierCalc& Bezier, const int32 Trimmed);
+    private: void UpdateBounds();
+    private: void CreateMesh(const bool FullRebuild);
+    private: void UpdatePosition();
+    private: void UpdateControlPoints();
+    private: void UpdateMaterials();
+    private: bool UseAsyncBuild() const;
+    private: void LaunchAsyncBuild(bool Recalculate);
+    private: void CancelAsyncBuild();
+    private: void CalculateSideLines();
+    private: bool SideLinesVisible() const;
+    private: void SetSideLineMeshVisibility(const bool Visible);
+    private: static void BuildSideLines(const FBezierCalc& Bezier, TArray<FSideLine>& InOutSideLines, const int32 NumPoints, const FVector& MeshUpVector, TArray<FLineBuild>& OutBuilds);
+    private: static void LayoutSideLines(TArray<FSideLine>& InOutSideLines);
+    private: void CommitSideLines(TArray<FLineBuild>& Builds);
+    private: void UpdateSidelineMaterials();
+    private: void ResetDebugLines() const;
+
+    // PUBLIC UPROPERTIES
+
+    // Bezier Section
+    
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Bezier")
+    TArray<FVector> Points;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Bezier")
+    bool HardCorners = true;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Bezier")
+    float LineWidth = 10;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Bezier", meta=(EditCondition="!HardCorners", ClampMin = "0.5", ClampMax = "0.99"))
+    float TessellationQuality = 0.95;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Bezier", meta=(EditCondition="!HardCorners"))
+    float TangentStrength = 0.3; // In fraction of a segment. Must not be greater than 0.5.
+
+    // If above 0, AppendPoints() trims the oldest points to keep the line at this many points.
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Bezier", meta=(ClampMin = "0"))
+    int32 MaxPoints = 0;
+
+    // Appearance Section
+    
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Main Appearance")
+    FLinearColor LineBodyColor = FLinearColor(0, 0.03, 0.6, 1);
+    
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Main Appearance")
+    ELineRendererStyle LineStyle = ELineRendererStyle::SolidColor;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Main Appearance")
+    ELineRendererStyle ArrowHeadStyle = ELineRendererStyle::SolidColor;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Main Appearance")
+    float UvDensity = 1;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Main Appearance")
+    float AnimationSpeed = 1;
+
+    // Passes the material parameters as custom primitive data, so all lines of a style share one
+    // material instance and can be batched. The materials must read Color1, Color2, UvDensity and
+    // AnimationSpeed from custom primitive data, or the lines are drawn with their defaults.
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Main Appearance")
+    bool ParametersInPrimitiveData = false;
+
+    // Arrow Heads
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Arrowhead Appearance")
+    bool StartArrow = false;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Arrowhead Appearance")
+    bool EndArrow = false;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Arrowhead Appearance")
+    FLinearColor ArrowheadColor = FLinearColor(0, 0.24, 0.54, 1);
+    
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Arrowhead Appearance", meta=(EditCondition="StartArrow || EndArrow"))
+    float ArrowScale = 1;
+
+    // Control points
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Control Point Appearance")
+    bool ShowControlPoints = true;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Control Point Appearance", meta=(EditCondition="ShowControlPoints"))
+    FLinearColor ControlPointColor = FLinearColor(0, 0, 0, 1);
+    
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Control Point Appearance", meta=(EditCondition="ShowControlPoints"))
+    float ControlPointScale = 1;
+
+    // Sidelines Section
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Sidelines")
+    bool ShowSideLines = true;
+
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Sidelines")
+    TArray<FSideLine> SideLines;
+    
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Sidelines")
+    FLinearColor SideLineColor;
+    
+    // Orientation Section
+    
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Orientation")
+    bool CameraFacing = false;
+    
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Orientation", meta=(EditCondition="!CameraFacing"))
+    FVector UpVector = FVector(0, 0, 1);
+
+    // Updates Section
+
+    // Lines are updated centrally by ULineRendererSubsystem and don't need to tick. Enable this
+    // only if a subclass or blueprint needs Tick().
+    public: UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Line Renderer|Updates")
+    bool EnableActorTick = false;
+
+    // Build the bezier, mesh and sidelines on a worker thread instead of during ChangeDetection().
+    // The line keeps showing its previous shape until the build is done, usually a frame later.
+    // Only applies in game worlds.
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Updates")
+    bool AsyncUpdates = false;
+
+    // PRIVATE UPROPERTIES
+
+    public: UPROPERTY()
+    ULineMesh* LineMesh;
+
+    public: UPROPERTY()
+    TArray<ULineMesh*> SideLineMeshes;
+
+    public: UPROPERTY()
+    ULineControlPoints* ControlPoints = nullptr;
+
+    // PRIVATE PROPERTIES
+    
+    private: EPhases DirtyPhase = EPhases::End; // Earliest phase invalidated by setters or editor changes.
+    private: bool MeshSettingsDirty = false;
+    private: int32 UpdateDepth = 0; // Nesting of BeginUpdate()/EndUpdate().
+    private: bool UpdatePending = false; // Queued with ULineRendererSubsystem for the end of the frame.
+    private: bool PendingFingerprintCheck = false; // Set when the pending changes may include direct writes.
+    private: uint64 SideLineFingerprint = 0;
+    private: uint64 TessellationFingerprint = 0;
+    private: uint64 PositionFingerprint = 0;
+    private: uint64 MaterialFingerprint = 0;
+    private: FVector CameraForward = FVector(0, 0, -1);
+    private: FVector OldCameraForward = FVector(0, 0, -1);
+    private: FVector CameraLocation = FVector(0, 0, 1);
+    private: FVector OldCameraLocation = FVector(0, 0, 1);
+    private: FVector EffectiveUpVector = FVector(0, 0, 1);
+    private: bool IncrementalTessellation = false;
+    private: int32 StreamTrimmed = 0; // Points trimmed off the front since the last calculation.
+    private: FTessellationSplice TessellationSplice;
+    // Reused builds for CalculateSideLines().
+    private: TArray<FLineBuild> SideLineBuilds;
+    private: bool SideLineLayoutDirty = true; // The line was recalculated since the sideline meshes were built.
+    // Background build in flight, if any.
+    private: TSharedPtr<FLineBuildJob> PendingBuild;
+    private: TSharedPtr<FLineBuildJob> SpareBuild; // Last finished build, reused by the next one.
+    private: UE::Tasks::FTask PendingTask;
+};
+
+// Batches changes to a line for as long as it is in scope, with BeginUpdate() and EndUpdate().
+class LINERENDERER_API FLineRendererUpdateScope
+{
+    public: explicit FLineRendererUpdateScope(ALineRenderer* InLine);
+    public: ~FLineRendererUpdateScope();
+
+    public: FLineRendererUpdateScope(const FLineRendererUpdateScope&) = delete;
+    public: FLineRendererUpdateScope& operator=(const FLineRendererUpdateScope&) = delete;
+
+    private: ALineRenderer* Line = nullptr;
+};
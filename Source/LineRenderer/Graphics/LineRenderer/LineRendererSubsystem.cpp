@@ -0,0 +1,481 @@
+﻿// Copyright Hollywood Camera Work
+
+#include "LineRendererSubsystem.h"
+
+#include "Algo/Sort.h"
+#include "Camera/PlayerCameraManager.h"
+#include "GameFramework/PlayerController.h"
+
+#include "LineRendererActor.h"
+#include "LineScratchStats.h"
+
+//
+// UPDATES
+//
+
+void ULineRendererSubsystem::Tick(const float DeltaTime)
+{
+    // Applies the changes lines batched up this frame, and commits finished background builds.
+    // Then reads the camera once for all lines, and re-orients the camera facing lines that it
+    // has moved too far for.
+
+    Super::Tick(DeltaTime);
+
+    RemoveStaleLines();
+
+    for (int32 i = 0; i < PendingUpdates.Num(); ++i) {
+        ALineRenderer* Line = PendingUpdates[i].Get();
+        if (IsValid(Line)) {
+            Line->FlushUpdates();
+        }
+    }
+    PendingUpdates.Reset();
+
+    for (int32 i = PendingBuilds.Num() - 1; i >= 0; --i) {
+        ALineRenderer* Line = PendingBuilds[i].Get();
+        if (!IsValid(Line) || Line->CommitAsyncBuild()) {
+            PendingBuilds.RemoveAtSwap(i, 1, false);
+        }
+    }
+
+    const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+    const APlayerCameraManager* CamManager = PlayerController ? PlayerController->PlayerCameraManager : nullptr;
+    if (CamManager == nullptr) {
+        return;
+    }
+
+    const FVector CameraLocation = CamManager->GetCameraLocation();
+    const FVector CameraForward = CamManager->GetCameraRotation().Vector();
+
+    QueueCameraUpdates(PlayerController, CameraLocation, CameraForward);
+    ProcessCameraUpdates(CameraLocation, CameraForward);
+
+    // Builds launched by this frame's updates are committed next frame at the earliest.
+    UpdateStats.PendingBuilds = PendingBuilds.Num();
+    UpdateStats.ScratchAllocations = FLineScratchStats::ConsumeAllocations();
+}
+
+void ULineRendererSubsystem::QueueCameraUpdates(const APlayerController* Player, const FVector& CameraLocation, const FVector& CameraForward)
+{
+    // Collects the lines that need re-orienting, and sorts them so the ones that look the most
+    // wrong come first. Lines on screen go before lines off screen. Within those, priority is the
+    // orientation error times the size of the line on screen, which favors near and large lines.
+    // Lines that keep getting deferred slowly move up. Once deferred for PromoteAfterFrames, they go
+    // before everything else, longest waiting first, so off screen lines aren't starved either.
+
+    const bool HaveView = QueryContext.Init(Player);
+    const float ViewSize = HaveView ? QueryContext.ViewRect.Width() : 1000.0f;
+
+    UpdateQueue.Reset();
+
+    for (int32 i = 0; i < Lines.Num(); ++i) {
+        const ALineRenderer* Line = Lines[i].Get();
+        if (!IsValid(Line) || !Line->CameraFacing || !Line->NeedsCameraUpdate(CameraLocation, CameraForward)) {
+            LineDeferredFrames[i] = 0;
+            continue;
+        }
+
+        const FBox& Bounds = LineBounds[i];
+        FQueuedUpdate Entry;
+        Entry.Index = i;
+        Entry.DeferredFrames = LineDeferredFrames[i];
+        Entry.Overdue = PromoteAfterFrames > 0 && Entry.DeferredFrames >= PromoteAfterFrames;
+
+        if (Bounds.IsValid) {
+            Entry.Distance = FMath::Sqrt(Bounds.ComputeSquaredDistanceToPoint(CameraLocation));
+
+            // Size on screen, from the projected bounds if they're fully in front of the camera,
+            // and otherwise from the angle they cover.
+            float ScreenSize = Bounds.GetExtent().Size() * 2 / FMath::Max(Entry.Distance, 1.0f) * ViewSize;
+            FBox2D ScreenBounds(ForceInit);
+            if (HaveView && QueryContext.ProjectBounds(Bounds, ScreenBounds)) {
+                const FIntRect& View = QueryContext.ViewRect;
+                Entry.OnScreen = ScreenBounds.Max.X >= View.Min.X && ScreenBounds.Min.X <= View.Max.X && ScreenBounds.Max.Y >= View.Min.Y && ScreenBounds.Min.Y <= View.Max.Y;
+                ScreenSize = ScreenBounds.GetSize().Size();
+            } else {
+                // Straddles the camera plane, or there's no view. On screen unless it's all behind.
+                const FVector ToCenter = Bounds.GetCenter() - CameraLocation;
+                Entry.OnScreen = FVector::DotProduct(ToCenter, CameraForward) > -Bounds.GetExtent().Size();
+            }
+
+            const float Error = Line->OrientationError(CameraLocation, CameraForward, Entry.Distance);
+            Entry.Priority = Error * ScreenSize * (1 + LineDeferredFrames[i]);
+        }
+
+        UpdateQueue.Add(Entry);
+    }
+
+    Algo::Sort(UpdateQueue, [](const FQueuedUpdate& A, const FQueuedUpdate& B) {
+        if (A.Overdue != B.Overdue) {
+            return A.Overdue;
+        }
+        if (A.Overdue && A.DeferredFrames != B.DeferredFrames) {
+            return A.DeferredFrames > B.DeferredFrames;
+        }
+        if (A.OnScreen != B.OnScreen) {
+            return A.OnScreen;
+        }
+        if (A.Priority != B.Priority) {
+            return A.Priority > B.Priority;
+        }
+        return A.Distance < B.Distance;
+    });
+}
+
+void ULineRendererSubsystem::ProcessCameraUpdates(const FVector& CameraLocation, const FVector& CameraForward)
+{
+    // Updates queued lines until the budget runs out. The rest still need updating next frame, so
+    // they are simply queued again then.
+
+    const double StartTime = FPlatformTime::Seconds();
+    const double Budget = UpdateBudgetMs / 1000.0;
+
+    UpdateStats = FLineUpdateStats();
+    UpdateStats.QueueDepth = UpdateQueue.Num();
+
+    int32 Next = 0;
+    for (; Next < UpdateQueue.Num(); ++Next) {
+        if (Budget > 0 && Next > 0 && FPlatformTime::Seconds() - StartTime >= Budget) {
+            break;
+        }
+
+        const int32 Index = UpdateQueue[Next].Index;
+        if (ALineRenderer* Line = Lines[Index].Get()) {
+            Line->UpdateCamera(CameraLocation, CameraForward);
+        }
+        LineDeferredFrames[Index] = 0;
+    }
+
+    UpdateStats.Updated = Next;
+
+    for (int32 i = Next; i < UpdateQueue.Num(); ++i) {
+        const FQueuedUpdate& Entry = UpdateQueue[i];
+        const int32 DeferredFrames = ++LineDeferredFrames[Entry.Index];
+        UpdateStats.Deferred++;
+        UpdateStats.DeferredOnScreen += Entry.OnScreen ? 1 : 0;
+        UpdateStats.MaxDeferredFrames = FMath::Max(UpdateStats.MaxDeferredFrames, DeferredFrames);
+    }
+
+    UpdateStats.UpdateMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+}
+
+TStatId ULineRendererSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(ULineRendererSubsystem, STATGROUP_Tickables);
+}
+
+//
+// REGISTRY
+//
+
+void ULineRendererSubsystem::RegisterLine(ALineRenderer* Line)
+{
+    if (Line == nullptr || LineIndexes.Contains(Line)) {
+        return;
+    }
+
+    LineIndexes.Add(Line, Lines.Num());
+    Lines.Add(Line);
+    LineBounds.Add(FBox(ForceInit));
+    LineDeferredFrames.Add(0);
+    TreeDirty = true;
+}
+
+void ULineRendererSubsystem::UnregisterLine(ALineRenderer* Line)
+{
+    PendingUpdates.RemoveSwap(Line, false);
+    PendingBuilds.RemoveSwap(Line, false);
+
+    const int32* Index = LineIndexes.Find(Line);
+    if (Index != nullptr) {
+        RemoveLineAt(*Index);
+    }
+}
+
+bool ULineRendererSubsystem::IsRegistered(const ALineRenderer* Line) const
+{
+    return LineIndexes.Contains(Line);
+}
+
+void ULineRendererSubsystem::RemoveLineAt(const int32 Index)
+{
+    LineIndexes.Remove(Lines[Index]);
+
+    // Swap the last line into the hole.
+    Lines.RemoveAtSwap(Index, 1, false);
+    LineBounds.RemoveAtSwap(Index, 1, false);
+    LineDeferredFrames.RemoveAtSwap(Index, 1, false);
+    if (Index < Lines.Num()) {
+        LineIndexes[Lines[Index]] = Index;
+    }
+
+    TreeDirty = true;
+}
+
+void ULineRendererSubsystem::RemoveStaleLines()
+{
+    // Drops lines that were destroyed without unregistering. Their queued updates and builds are
+    // dropped by Tick() as it comes across them.
+
+    for (int32 i = Lines.Num() - 1; i >= 0; --i) {
+        if (Lines[i].IsStale()) {
+            RemoveLineAt(i);
+        }
+    }
+}
+
+void ULineRendererSubsystem::UpdateLineBounds(const ALineRenderer* Line, const FBox& Bounds)
+{
+    const int32* Index = LineIndexes.Find(Line);
+    if (Index == nullptr) {
+        return;
+    }
+
+    LineBounds[*Index] = Bounds;
+    BoundsDirty = true;
+}
+
+void ULineRendererSubsystem::AddPendingBuild(ALineRenderer* Line)
+{
+    // Unregistered lines, e.g. ones that haven't begun play yet, build synchronously instead, see
+    // ALineRenderer::UseAsyncBuild().
+    if (IsRegistered(Line)) {
+        PendingBuilds.AddUnique(Line);
+    }
+}
+
+void ULineRendererSubsystem::AddPendingUpdate(ALineRenderer* Line)
+{
+    // The line only queues itself once per frame, so this doesn't need to check for duplicates.
+    // Unregistered lines flush their updates right away instead, see ALineRenderer::RequestUpdate().
+    if (IsRegistered(Line)) {
+        PendingUpdates.Add(Line);
+    }
+}
+
+const TArray<TWeakObjectPtr<ALineRenderer>>& ULineRendererSubsystem::GetLines() const
+{
+    return Lines;
+}
+
+const FLineUpdateStats& ULineRendererSubsystem::GetUpdateStats() const
+{
+    return UpdateStats;
+}
+
+//
+// PICKING
+//
+
+FLinePickResult ULineRendererSubsystem::PickLine(const APlayerController* Player, const FVector2D& ScreenPos, const float RadiusPixels)
+{
+    // Captures the player's view once for the whole pick.
+    
+    if (!QueryContext.Init(Player)) {
+        return FLinePickResult{};
+    }
+    return PickLine(QueryContext, ScreenPos, RadiusPixels);
+}
+
+FLinePickResult ULineRendererSubsystem::PickLine(FLineHitQueryContext& Context, const FVector2D& ScreenPos, const float RadiusPixels)
+{
+    // Finds the closest control point within RadiusPixels of ScreenPos, or if there isn't one, the
+    // closest line. Points always get click priority. Only lines whose bounds are near the pick ray
+    // are hit detected.
+
+    FLinePickResult Result;
+
+    if (!Context.IsValid() || Lines.Num() == 0) {
+        return Result;
+    }
+
+    // The pick ray, and how much it widens with distance to cover the pick radius. The offset
+    // origin covers orthographic views, where the ray moves instead of widening.
+
+    FVector RayOrigin, RayDirection, EdgeOrigin, EdgeDirection;
+    Context.Deproject(ScreenPos, RayOrigin, RayDirection);
+    Context.Deproject(ScreenPos + FVector2D(RadiusPixels, 0), EdgeOrigin, EdgeDirection);
+
+    const float OriginMargin = FVector::Dist(RayOrigin, EdgeOrigin);
+    const float Cosine = FMath::Max(FVector::DotProduct(RayDirection, EdgeDirection), UE_KINDA_SMALL_NUMBER);
+    const float Spread = FVector::CrossProduct(RayDirection, EdgeDirection).Size() / Cosine;
+
+    FindCandidates(RayOrigin, RayDirection, OriginMargin, Spread);
+
+    // Hit detect points
+
+    for (const int32 Index : Candidates) {
+        ALineRenderer* Line = Lines[Index].Get();
+        if (!IsValid(Line) || !Line->ShowControlPoints) {
+            continue;
+        }
+
+        const FHitDetectionResult Hit = Line->HitDetectPoints(Context, ScreenPos, FMath::Min(Result.Hit.Distance, RadiusPixels));
+        if (Hit.Valid && Hit.Distance < Result.Hit.Distance) {
+            Result.Hit = Hit;
+            Result.Line = Line;
+            Result.IsControlPoint = true;
+        }
+    }
+
+    if (Result.Line != nullptr) {
+        return Result;
+    }
+
+    // Hit detect splines. This only runs if we didn't get any points, because it's more expensive,
+    // and points always get click priority anyway.
+
+    for (const int32 Index : Candidates) {
+        ALineRenderer* Line = Lines[Index].Get();
+        if (!IsValid(Line)) {
+            continue;
+        }
+
+        const FHitDetectionResult Hit = Line->HitDetectSpline(Context, ScreenPos, FMath::Min(Result.Hit.Distance, RadiusPixels));
+        if (Hit.Valid && Hit.Distance < Result.Hit.Distance) {
+            Result.Hit = Hit;
+            Result.Line = Line;
+        }
+    }
+
+    return Result;
+}
+
+void ULineRendererSubsystem::FindCandidates(const FVector& RayOrigin, const FVector& RayDirection, const float OriginMargin, const float Spread)
+{
+    // Collects the lines whose bounds, grown by the width of the pick cone at their far side, are
+    // crossed by the pick ray.
+
+    if (TreeDirty) {
+        RebuildTree();
+    } else if (BoundsDirty) {
+        RefitTree();
+    }
+
+    Candidates.Reset();
+    if (Nodes.Num() == 0) {
+        return;
+    }
+
+    const FVector RayEnd = RayOrigin + RayDirection * UE_LARGE_WORLD_MAX;
+    const FVector RayVector = RayEnd - RayOrigin;
+
+    const auto Touches = [&](const FBox& Bounds) {
+        if (!Bounds.IsValid) {
+            return false;
+        }
+        const float FarDistance = FVector::Dist(RayOrigin, Bounds.GetCenter()) + Bounds.GetExtent().Size();
+        const FBox Grown = Bounds.ExpandBy(OriginMargin + FarDistance * Spread);
+        return Grown.IsInside(RayOrigin) || FMath::LineBoxIntersection(Grown, RayOrigin, RayEnd, RayVector);
+    };
+
+    TArray<int32, TInlineAllocator<64>> Stack;
+    Stack.Add(0);
+
+    while (Stack.Num() > 0) {
+        const int32 NodeIndex = Stack.Pop(false);
+        const FNode& Node = Nodes[NodeIndex];
+        if (!Touches(Node.Bounds)) {
+            continue;
+        }
+
+        if (Node.SecondChild != INDEX_NONE) {
+            Stack.Add(Node.SecondChild);
+            Stack.Add(NodeIndex + 1);
+            continue;
+        }
+
+        for (int32 i = Node.First; i < Node.First + Node.Num; ++i) {
+            const int32 Index = TreeOrder[i];
+            if (Touches(LineBounds[Index])) {
+                Candidates.Add(Index);
+            }
+        }
+    }
+}
+
+//
+// TREE
+//
+
+void ULineRendererSubsystem::RebuildTree()
+{
+    // Top-down build. Each node sorts its lines along the longest axis of their centers and splits
+    // them in half.
+
+    TreeDirty = false;
+    BoundsDirty = false;
+    Nodes.Reset();
+    TreeOrder.Reset();
+
+    if (Lines.Num() == 0) {
+        return;
+    }
+
+    TreeOrder.SetNumUninitialized(Lines.Num());
+    for (int32 i = 0; i < Lines.Num(); ++i) {
+        TreeOrder[i] = i;
+    }
+
+    Nodes.Reserve(2 * FMath::DivideAndRoundUp(Lines.Num(), LeafSize));
+    BuildNode(0, Lines.Num());
+}
+
+int32 ULineRendererSubsystem::BuildNode(const int32 First, const int32 Num)
+{
+    const int32 NodeIndex = Nodes.Add(FNode{FBox(ForceInit), First, Num, INDEX_NONE});
+
+    if (Num <= LeafSize) {
+        FBox Bounds(ForceInit);
+        for (int32 i = First; i < First + Num; ++i) {
+            Bounds += LineBounds[TreeOrder[i]];
+        }
+        Nodes[NodeIndex].Bounds = Bounds;
+        return NodeIndex;
+    }
+
+    FBox Centers(ForceInit);
+    for (int32 i = First; i < First + Num; ++i) {
+        const FBox& Bounds = LineBounds[TreeOrder[i]];
+        if (Bounds.IsValid) {
+            Centers += Bounds.GetCenter();
+        }
+    }
+
+    const FVector Size = Centers.IsValid ? Centers.GetSize() : FVector::ZeroVector;
+    const int32 Axis = (Size.X >= Size.Y && Size.X >= Size.Z) ? 0 : (Size.Y >= Size.Z ? 1 : 2);
+
+    Algo::Sort(MakeArrayView(TreeOrder.GetData() + First, Num), [this, Axis](const int32 A, const int32 B) {
+        return LineBounds[A].GetCenter()[Axis] < LineBounds[B].GetCenter()[Axis];
+    });
+
+    // Nodes may reallocate while building children, so don't hold on to references.
+    const int32 Half = Num / 2;
+    const int32 FirstChild = BuildNode(First, Half);
+    const int32 SecondChild = BuildNode(First + Half, Num - Half);
+
+    Nodes[NodeIndex].Bounds = Nodes[FirstChild].Bounds + Nodes[SecondChild].Bounds;
+    Nodes[NodeIndex].SecondChild = SecondChild;
+    return NodeIndex;
+}
+
+void ULineRendererSubsystem::RefitTree()
+{
+    // Children are always stored after their parents, so going backwards updates children first.
+
+    BoundsDirty = false;
+
+    for (int32 NodeIndex = Nodes.Num() - 1; NodeIndex >= 0; --NodeIndex) {
+        FNode& Node = Nodes[NodeIndex];
+
+        if (Node.SecondChild != INDEX_NONE) {
+            Node.Bounds = Nodes[NodeIndex + 1].Bounds + Nodes[Node.SecondChild].Bounds;
+            continue;
+        }
+
+        Node.Bounds = FBox(ForceInit);
+        for (int32 i = Node.First; i < Node.First + Node.Num; ++i) {
+            Node.Bounds += LineBounds[TreeOrder[i]];
+        }
+    }
+}
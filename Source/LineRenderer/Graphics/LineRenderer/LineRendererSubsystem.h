@@ -0,0 +1,130 @@
+﻿// Copyright Hollywood Camera Work
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "LineRendererIncludes.h"
+#include "LineHitQueryContext.h"
+#include "LineRendererSubsystem.generated.h"
+
+class ALineRenderer;
+class APlayerController;
+
+// STRUCTS
+
+struct FLinePickResult
+{
+    ALineRenderer* Line = nullptr;
+    bool IsControlPoint = false; // If true, Hit.Segment is the control point index.
+    FHitDetectionResult Hit;
+};
+
+// What the camera driven updates did in the last frame, from ULineRendererSubsystem::GetUpdateStats().
+struct FLineUpdateStats
+{
+    int32 QueueDepth = 0; // Lines that needed re-orienting.
+    int32 Updated = 0;
+    int32 Deferred = 0; // Carried over to later frames by the budget.
+    int32 DeferredOnScreen = 0;
+    int32 MaxDeferredFrames = 0; // Longest any queued line has been waiting.
+    int32 PendingBuilds = 0; // Background builds still running.
+    int32 ScratchAllocations = 0; // Scratch buffer allocations since the previous stats, from FLineScratchStats.
+    float UpdateMs = 0;
+};
+
+// Registry of all line renderers in a world. Keeps a hierarchy of their world space bounds, so that
+// picking only runs the per-line hit detection on lines near the pick ray. Also ticks once per
+// frame on behalf of all lines, so the lines themselves don't need to tick, applies their batched
+// changes and commits their background builds. Camera facing lines are re-oriented under a time
+// budget, most visible first.
+UCLASS()
+class LINERENDERER_API ULineRendererSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+    // METHODS
+
+    public: virtual void Tick(float DeltaTime) override;
+    public: virtual TStatId GetStatId() const override;
+    public: void RegisterLine(ALineRenderer* Line);
+    public: void UnregisterLine(ALineRenderer* Line);
+    public: bool IsRegistered(const ALineRenderer* Line) const;
+    public: void UpdateLineBounds(const ALineRenderer* Line, const FBox& Bounds);
+    public: void AddPendingBuild(ALineRenderer* Line);
+    public: void AddPendingUpdate(ALineRenderer* Line);
+    public: const TArray<TWeakObjectPtr<ALineRenderer>>& GetLines() const;
+    public: const FLineUpdateStats& GetUpdateStats() const;
+    public: FLinePickResult PickLine(const APlayerController* Player, const FVector2D& ScreenPos, const float RadiusPixels);
+    public: FLinePickResult PickLine(FLineHitQueryContext& Context, const FVector2D& ScreenPos, const float RadiusPixels);
+    private: void RemoveLineAt(const int32 Index);
+    private: void RemoveStaleLines();
+    private: void QueueCameraUpdates(const APlayerController* Player, const FVector& CameraLocation, const FVector& CameraForward);
+    private: void ProcessCameraUpdates(const FVector& CameraLocation, const FVector& CameraForward);
+    private: void FindCandidates(const FVector& RayOrigin, const FVector& RayDirection, const float OriginMargin, const float Spread);
+    private: void RebuildTree();
+    private: int32 BuildNode(const int32 First, const int32 Num);
+    private: void RefitTree();
+
+    // PROPERTIES
+
+    public: static constexpr int32 LeafSize = 4;
+
+    // Time per frame for re-orienting camera facing lines. Lines that don't fit are carried over
+    // to the next frame. At least one line is updated every frame. 0 means no limit.
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Updates")
+    float UpdateBudgetMs = 2;
+
+    // Lines deferred this many frames in a row are updated before all others, whether on screen or
+    // not. 0 means never.
+    public: UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Line Renderer|Updates")
+    int32 PromoteAfterFrames = 8;
+
+    // PRIVATE PROPERTIES
+
+    private: struct FNode
+    {
+        FBox Bounds;
+        int32 First = 0; // First entry in TreeOrder.
+        int32 Num = 0;
+        int32 SecondChild = INDEX_NONE; // INDEX_NONE for leaves. The first child follows its parent.
+    };
+
+    private: struct FQueuedUpdate
+    {
+        int32 Index = 0; // In Lines.
+        bool OnScreen = false;
+        bool Overdue = false; // Deferred for PromoteAfterFrames or more.
+        int32 DeferredFrames = 0;
+        float Priority = 0; // Estimated error in pixels, grown by the time spent waiting.
+        float Distance = 0;
+    };
+
+    // Registered lines, their bounds and how many frames they have waited for an update, in the
+    // same order. Lines unregister themselves in EndPlay(), but are only held weakly, so that one
+    // destroyed without it is dropped instead of dangling.
+    private: TArray<TWeakObjectPtr<ALineRenderer>> Lines;
+    private: TArray<FBox> LineBounds;
+    private: TArray<int32> LineDeferredFrames;
+    private: TMap<TWeakObjectPtr<const ALineRenderer>, int32> LineIndexes;
+
+    // Hierarchy over the line bounds. Rebuilt when lines are added or removed, refitted when they
+    // only move.
+    private: TArray<FNode> Nodes;
+    private: TArray<int32> TreeOrder;
+    private: bool TreeDirty = false;
+    private: bool BoundsDirty = false;
+
+    // Lines with changes to apply at the end of the frame, and lines with a background build in
+    // flight, committed from Tick() when done. Only registered lines are queued.
+    private: TArray<TWeakObjectPtr<ALineRenderer>> PendingUpdates;
+    private: TArray<TWeakObjectPtr<ALineRenderer>> PendingBuilds;
+
+    private: TArray<FQueuedUpdate> UpdateQueue;
+    private: FLineUpdateStats UpdateStats;
+
+    // Scratch for PickLine(). Also used by Tick() for the camera view.
+    private: TArray<int32> Candidates;
+    private: FLineHitQueryContext QueryContext;
+};
@@ -1,4 +1,4 @@
-﻿// Copyright Hollywood Camera Work
-
-
-#include "LineRendererTestWidget.h"
+﻿// Copyright Hollywood Camera Work
+
+
+#include "LineRendererTestWidget.h"
@@ -0,0 +1,15 @@
+﻿// Copyright Hollywood Camera Work
+
+#include "LineScratchStats.h"
+
+std::atomic<int32> FLineScratchStats::Allocations{0};
+
+void FLineScratchStats::CountAllocation()
+{
+    Allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+int32 FLineScratchStats::ConsumeAllocations()
+{
+    return Allocations.exchange(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,36 @@
+﻿// Copyright Hollywood Camera Work
+
+#pragma once
+
+#include <atomic>
+
+#include "CoreMinimal.h"
+
+// Counts the heap allocations made by the reusable buffers on the per-frame paths (bezier
+// calculation, mesh building, sidelines, background builds, hit detection, batch evaluation).
+// Buffers are sized with Reserve(), which counts when a buffer has to grow, and objects that can't
+// be reused are counted where they're created. Once warmed up, e.g. while the camera moves around
+// unchanged lines, the count should stay at 0. Temporaries that don't outlive a call go on
+// FMemStack instead, which is a linear arena per thread, released with an FMemMark. Allocations
+// made by the engine, e.g. when uploading meshes, aren't counted. Counted from any thread.
+// ULineRendererSubsystem reports the count once per frame in FLineUpdateStats.
+class LINERENDERER_API FLineScratchStats
+{
+    // METHODS
+
+    public: template<typename ArrayType>
+    static void Reserve(ArrayType& Array, const int32 Num)
+    {
+        if (Num > Array.Max()) {
+            CountAllocation();
+            Array.Reserve(Num);
+        }
+    }
+
+    public: static void CountAllocation();
+    public: static int32 ConsumeAllocations(); // Returns the count, and starts over from 0.
+
+    // PRIVATE PROPERTIES
+
+    private: static std::atomic<int32> Allocations;
+};
@@ -0,0 +1,171 @@
+﻿// Copyright Hollywood Camera Work
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Array that can drop elements off its front without moving the rest, for lines that are trimmed
+// at the start while they grow at the end. Trimmed elements stay in place in front of the first
+// one, and are only reclaimed once there are more of them than live elements, so a stream of
+// trims costs in proportion to what's trimmed. Indexes, Num() and iteration only cover the live
+// elements. Inserting and removing moves whichever side of the change is shorter, using the room
+// in front if there is enough. Only for types that can be moved with a plain memory copy.
+template <typename T>
+class TLineTrimArray
+{
+    // METHODS
+
+    public: TLineTrimArray& operator=(const TArray<T>& Other)
+    {
+        Data = Other;
+        Head = 0;
+        return *this;
+    }
+
+    public: int32 Num() const
+    {
+        return Data.Num() - Head;
+    }
+
+    public: int32 Max() const
+    {
+        return Data.Max() - Head;
+    }
+
+    public: T* GetData()
+    {
+        return Data.GetData() + Head;
+    }
+
+    public: const T* GetData() const
+    {
+        return Data.GetData() + Head;
+    }
+
+    public: T& operator[](const int32 Index)
+    {
+        return Data[Head + Index];
+    }
+
+    public: const T& operator[](const int32 Index) const
+    {
+        return Data[Head + Index];
+    }
+
+    public: T& Last()
+    {
+        return Data.Last();
+    }
+
+    public: const T& Last() const
+    {
+        return Data.Last();
+    }
+
+    public: T* begin()
+    {
+        return GetData();
+    }
+
+    public: T* end()
+    {
+        return Data.GetData() + Data.Num();
+    }
+
+    public: const T* begin() const
+    {
+        return GetData();
+    }
+
+    public: const T* end() const
+    {
+        return Data.GetData() + Data.Num();
+    }
+
+    public: void Reserve(const int32 Number)
+    {
+        Data.Reserve(Head + Number);
+    }
+
+    public: void Reset()
+    {
+        Data.Reset();
+        Head = 0;
+    }
+
+    public: void SetNum(const int32 NewNum, const bool bAllowShrinking = true)
+    {
+        Data.SetNum(Head + NewNum, bAllowShrinking);
+    }
+
+    public: void SetNumZeroed(const int32 NewNum, const bool bAllowShrinking = true)
+    {
+        Data.SetNumZeroed(Head + NewNum, bAllowShrinking);
+    }
+
+    public: void SetNumUninitialized(const int32 NewNum, const bool bAllowShrinking = true)
+    {
+        Data.SetNumUninitialized(Head + NewNum, bAllowShrinking);
+    }
+
+    public: int32 Add(const T& Item)
+    {
+        return Data.Add(Item) - Head;
+    }
+
+    public: void AddZeroed(const int32 Count)
+    {
+        Data.AddZeroed(Count);
+    }
+
+    public: void Append(const T* Items, const int32 Count)
+    {
+        Data.Append(Items, Count);
+    }
+
+    public: void Append(const TArray<T>& Items)
+    {
+        Data.Append(Items);
+    }
+
+    public: void InsertUninitialized(const int32 Index, const int32 Count)
+    {
+        if (Count <= Head && Index < Num() - Index) {
+            FMemory::Memmove(Data.GetData() + Head - Count, Data.GetData() + Head, Index * sizeof(T));
+            Head -= Count;
+        } else {
+            Data.InsertUninitialized(Head + Index, Count);
+        }
+    }
+
+    public: void RemoveAt(const int32 Index, const int32 Count, const bool bAllowShrinking = true)
+    {
+        if (Index < Num() - Index - Count) {
+            FMemory::Memmove(Data.GetData() + Head + Count, Data.GetData() + Head, Index * sizeof(T));
+            TrimFront(Count);
+        } else {
+            Data.RemoveAt(Head + Index, Count, bAllowShrinking);
+        }
+    }
+
+    public: void TrimFront(const int32 Count)
+    {
+        Head += Count;
+        if (Head > Num()) {
+            Data.RemoveAt(0, Head, false);
+            Head = 0;
+        }
+    }
+
+    // PRIVATE PROPERTIES
+
+    private: TArray<T> Data;
+    private: int32 Head = 0; // Trimmed elements in front of the first one.
+};
+
+// Lets the live elements be passed as an array view, and searched with the Algo functions.
+template <typename T>
+struct TIsContiguousContainer<TLineTrimArray<T>>
+{
+    static constexpr bool Value = true;
+};
@@ -1,44 +1,46 @@
-// Copyright Epic Games, Inc. All Rights Reserved.
-
-using UnrealBuildTool;
-
-public class LineRenderer : ModuleRules
-{
-	public LineRenderer(ReadOnlyTargetRules Target) : base(Target)
-	{
-		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
-	
-		PublicDependencyModuleNames.AddRange(new string[]
-		{
-			"Core",
-			"CoreUObject",
-			"Engine",
-			"InputCore",
-			"UnrealEd",
-			"ProceduralMeshComponent",
-		});
-
-		PrivateDependencyModuleNames.AddRange(new string[]
-		{
-			"SlateCore",
-			"Slate",
-			"UMG",
-		});
-
-		PublicIncludePaths.AddRange( new string[]
-		{
-			"LineRenderer",
-			"LineRenderer/Util",
-		});
-
-		PrivateDependencyModuleNames.AddRange(new string[] {  });
-
-		// Uncomment if you are using Slate UI
-		// PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore" });
-		
-		// Uncomment if you are using online features
-		// PrivateDependencyModuleNames.Add("OnlineSubsystem");
-
-		// To include OnlineSubsystemSteam, add it to the plugins section in your uproject file with the Enabled attribute set to true
-	}
-}
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class LineRenderer : ModuleRules
+{
+	public LineRenderer(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+	
+		PublicDependencyModuleNames.AddRange(new string[]
+		{
+			"Core",
+			"CoreUObject",
+			"Engine",
+			"InputCore",
+			"UnrealEd",
+			"ProceduralMeshComponent",
+			"RenderCore",
+			"RHI",
+		});
+
+		PrivateDependencyModuleNames.AddRange(new string[]
+		{
+			"SlateCore",
+			"Slate",
+			"UMG",
+		});
+
+		PublicIncludePaths.AddRange( new string[]
+		{
+			"LineRenderer",
+			"LineRenderer/Util",
+		});
+
+		PrivateDependencyModuleNames.AddRange(new string[] {  });
+
+		// Uncomment if you are using Slate UI
+		// PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore" });
+		
+		// Uncomment if you are using online features
+		// PrivateDependencyModuleNames.Add("OnlineSubsystem");
+
+		// To include OnlineSubsystemSteam, add it to the plugins section in your uproject file with the Enabled attribute set to true
+	}
+}
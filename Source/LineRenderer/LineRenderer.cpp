@@ -1,6 +1,6 @@
-// Copyright Epic Games, Inc. All Rights Reserved.
-
-#include "LineRenderer.h"
-#include "Modules/ModuleManager.h"
-
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, LineRenderer, "LineRenderer" );
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "LineRenderer.h"
+#include "Modules/ModuleManager.h"
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, LineRenderer, "LineRenderer" );
@@ -1,50 +1,46 @@
-﻿// Copyright Hollywood Camera Work
-
-#pragma once
-
-#include "CoreMinimal.h"
-
-class LINERENDERER_API FCryptUtil
-{
-    // HASHING
-
-    public: static TArray<uint8> MD5HashBytes(const FString& InputString);
-
-    // SETTINGS FINGERPRINTING
-
-    private: static void FingerprintHelper(TArray<uint8>& Array, int32 Value);
-    private: static void FingerprintHelper(TArray<uint8>& Array, int64 Value);
-    private: static void FingerprintHelper(TArray<uint8>& Array, const bool Value);
-    private: static void FingerprintHelper(TArray<uint8>& Array, float Value);
-    private: static void FingerprintHelper(TArray<uint8>& Array, double Value);
-    private: static void FingerprintHelper(TArray<uint8>& Array, const FString& Value);
-    private: static void FingerprintHelper(TArray<uint8>& Array, const FVector& Value);
-    private: static void FingerprintHelper(TArray<uint8>& Array, const FLinearColor& Color);
-    private: static void FingerprintHelper(TArray<uint8>& Array, const FColor& Color);
-    private: static void FingerprintHelper(TArray<uint8>& Array, const TArray<float>& FloatValues);
-    private: static void FingerprintHelper(TArray<uint8>& Array, const TArray<FVector>& Positions);
-    private: static void FingerprintHelper(TArray<uint8>& Array, const TArray<uint8>& Fingerprint);
-    private: static void FingerprintHelper(TArray<uint8>& Array, const TArray<TArray<uint8>>& Fingerprints);
-
-    private: template<typename T, typename... Args>
-    static void FingerprintInternal(TArray<uint8>& Array, T First, Args... Arguments)
-    {
-        FingerprintHelper(Array, First);
-        FingerprintInternal(Array, Arguments...);
-    }
-    
-    // Fingerprint function definition
-    public: template<typename... Args>
-    static TArray<uint8> Fingerprint(Args... Arguments)
-    {
-        TArray<uint8> Result;
-        
-        ([&Result](const auto& Arg) {
-            FingerprintHelper(Result, Arg);
-        }(Arguments), ...); // The comma operator is used here to separate calls for each argument
-
-        return MoveTemp(Result);
-    }
-
-    public: static bool FingerprintMatch(const TArray<uint8>& Fingerprint1, const TArray<uint8>& Fingerprint2);
-};
+﻿// Copyright Hollywood Camera Work
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Hash/xxhash.h"
+
+// Streaming fingerprint for change detection. Values are fed straight into a 64-bit xxHash, so
+// nothing is allocated or copied, however large the inputs are. FCryptUtil::Fingerprint() covers a
+// fixed list of values. Use this directly to fingerprint something piece by piece.
+class LINERENDERER_API FFingerprintBuilder
+{
+    public: void Add(int32 Value);
+    public: void Add(int64 Value);
+    public: void Add(const bool Value);
+    public: void Add(float Value);
+    public: void Add(double Value);
+    public: void Add(const FString& Value);
+    public: void Add(const FVector& Value);
+    public: void Add(const FLinearColor& Color);
+    public: void Add(const FColor& Color);
+    public: void Add(const TArray<float>& FloatValues);
+    public: void Add(const TArray<FVector>& Positions);
+    public: uint64 Finalize() const;
+
+    private: FXxHash64Builder Hasher;
+};
+
+class LINERENDERER_API FCryptUtil
+{
+    // HASHING
+
+    public: static TArray<uint8> MD5HashBytes(const FString& InputString);
+
+    // SETTINGS FINGERPRINTING
+
+    public: template<typename... Args>
+    static uint64 Fingerprint(const Args&... Arguments)
+    {
+        FFingerprintBuilder Builder;
+        (Builder.Add(Arguments), ...);
+        return Builder.Finalize();
+    }
+
+    public: static bool FingerprintMatch(const uint64 Fingerprint1, const uint64 Fingerprint2);
+};
@@ -1,5 +1,5 @@
-﻿// Copyright Hollywood Camera Work
-
-
-#include "HelperUtil.h"
-
+﻿// Copyright Hollywood Camera Work
+
+
+#include "HelperUtil.h"
+
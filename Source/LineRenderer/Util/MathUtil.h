@@ -1,10 +1,10 @@
-﻿// Copyright Hollywood Camera Work
-
-#pragma once
-
-#include "CoreMinimal.h"
-
-class LINERENDERER_API FMathUtil
-{
-    public: static float SnapToWholeNumber(const float Input, const float Range);
-};
+﻿// Copyright Hollywood Camera Work
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class LINERENDERER_API FMathUtil
+{
+    public: static float SnapToWholeNumber(const float Input, const float Range);
+};